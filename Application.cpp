@@ -30,12 +30,11 @@
 #include "LogSystem.h"
 #include "Settings.h"
 #include "SharpDisplay.h"
+#include "FramStorage.h"
 #include "Storage.h"
+#include "TwiMaster.h"
 #include "ViewManager.h"
 
-// Include Arduino libraries
-#include <Wire.h>
-
 // Include AVR libraries
 #include <avr/sleep.h>
 
@@ -44,6 +43,40 @@ namespace lr {
 namespace Application {
 
 
+/// The bus clock for all devices without an own clock.
+///
+static const uint32_t cDefaultBusClock = 100000;
+
+/// The bus clock for the FRAM storage chip.
+///
+/// The MB85RC256V supports 1MHz, but the TWI hardware of the
+/// ATmega328P is only specified up to 400kHz.
+///
+static const uint32_t cStorageBusClock = 400000;
+
+/// The bus clock for the DS3231 real time clock.
+///
+static const uint32_t cRtcBusClock = 400000;
+
+/// The pins of the DHT22 sensors, one for each channel.
+///
+static const uint8_t cSensorPins[] = {SENSOR_PINS};
+static_assert(sizeof(cSensorPins) == SENSOR_CHANNEL_COUNT, "SENSOR_PINS must contain SENSOR_CHANNEL_COUNT pins.");
+
+/// The pins of the display for each interface: chip select, clock and data.
+///
+static const uint8_t cDisplayPins[3][3] = {
+    {11, 9, 10}, // SoftwareInterface
+    {10, 13, 11}, // HardwareSpiInterface
+    {10, 4, 1}, // UsartSpiInterface
+};
+static_assert(SharpDisplay::DISPLAY_INTERFACE != SharpDisplay::UsartSpiInterface || KEY_ENTER_PIN != 4, "The USART interface of the display needs pin 4, move the enter key.");
+
+/// If the alarm of the real time clock wakes from the power-down mode.
+///
+static const bool cRtcAlarmWakeUp = RTC_ALARM_WAKEUP;
+
+
 /// The initial logo displayed on the screen.
 ///
 static const char cLogoText[] PROGMEM =
@@ -57,31 +90,183 @@ static const char cLogoText[] PROGMEM =
 static uint8_t gDisplayInfoRefreshCount; ///< A counter to delay the update of the info area.
 static OperationMode gOperationMode; ///< The current operation mode of the application.
 static DateTime gNextRecordTime; ///< The next time where a new record is created.
+static DateTime gAsyncDateTime; ///< The time read in the background.
+static SharpDisplay::Interface gDisplayInterface = SharpDisplay::DISPLAY_INTERFACE; ///< The interface of the display.
+static bool gAlarmWakeUp; ///< If the alarm is set, and wakes from the power-down mode.
     
     
-/// Wait a number of seconds in powersafe mode.
+/// Sleep until the next interrupt of timer 2.
+///
+/// The display driver is using timer 2 as interrupt source, it refreshes
+/// the display and checks the keys in this interrupt. While there are
+/// transfers on the I2C bus or to the display using a hardware interface,
+/// the microcontroller sleeps in idle mode, because the TWI, SPI and
+/// USART hardware stop in the power save mode.
+///
+void sleepUntilTimerInterrupt()
+{
+    if (TwiMaster::isIdle() && !SharpDisplay::isHardwareTransferRunning()) {
+        SMCR = _BV(SM1)|_BV(SM0); // Power-save mode.
+    } else {
+        SMCR = 0; // Idle mode.
+    }
+    SMCR |= _BV(SE); // Enable sleep mode.
+    sleep_cpu();
+    SMCR &= ~_BV(SE); // Disable sleep mode.
+}
+
+
+/// Check if an operation mode is saving power.
+///
+inline bool isPowerSavingMode(OperationMode mode)
+{
+    return mode == RecordingMode || mode == PowerSave;
+}
+
+
+/// Wait a number of seconds in power save mode.
 ///
-/// This function puts the microcontroller in power save mode and
-/// waits a number of seconds. This only works, because the display
-/// driver is using timer 2 as interrupt source. The interrupt for
-/// the display wakes the microcontroller from the power save mode.
+/// This only works, because the display driver is using timer 2 as
+/// interrupt source. The interrupt for the display wakes the
+/// microcontroller from the power save mode about 61 times a second.
 ///
 /// @param seconds The number of seconds to sleep.
 ///
-void powerSave(uint16_t seconds)
+void powerSaveWithTimer(uint16_t seconds)
 {
-    // Go to sleep (for 1/60s).
-    SMCR = _BV(SM1)|_BV(SM0); // Power-save mode.
     const uint32_t waitIntervals = (seconds*61); // This is almost a second.
-    for (uint32_t i = 0; i < waitIntervals; ++i) {
-        TCNT2 = 0; // reset the timer.
-        SMCR |= _BV(SE); // Enable sleep mode.
-        sleep_cpu();
-        SMCR &= ~_BV(SE); // Disable sleep mode.
-        if (KeyPad::hasNextKey()) {
-            break; // Stop waiting if there is a key press.
+    for (uint32_t i = 0; i < waitIntervals && !KeyPad::hasNextKey(); ++i) {
+        // Only count the timer interrupts, not the ones of the transfers.
+        while (!TwiMaster::isIdle() || SharpDisplay::isHardwareTransferRunning()) {
+            sleepUntilTimerInterrupt();
+        }
+        sleepUntilTimerInterrupt();
+    }
+}
+
+
+/// Wait a number of seconds in power-down mode.
+///
+/// Alarm 1 of the real time clock triggers every second in the power
+/// saving modes, see setOperationMode(). Its INT/SQW output and the
+/// keys wake the microcontroller from the power-down mode. In this
+/// mode all clocks stop, including timer 2. After each alarm, the
+/// microcontroller sleeps in power save mode until the next timer 2
+/// interrupt. This interrupt refreshes the display, which needs an
+/// inversion of VCOM about every second, and checks the keys.
+///
+/// Compared to waking up with each timer 2 interrupt, the oscillator
+/// runs only for about a millisecond each second.
+///
+/// @param seconds The number of seconds to sleep.
+///
+void powerSaveWithAlarm(uint16_t seconds)
+{
+    uint16_t elapsedSeconds = 0;
+    while (elapsedSeconds < seconds && !KeyPad::hasNextKey()) {
+        // The TWI and SPI hardware stop in the power-down mode.
+        while (!TwiMaster::isIdle() || SharpDisplay::isRefreshRunning()) {
+            sleepUntilTimerInterrupt();
+        }
+        // Sleep until the next alarm or key press.
+        KeyPad::setWakeUpEnabled(true);
+        cli();
+        // The timer interrupt may have started a refresh since the wait above.
+        if (!DS3231::isAlarmPending() && !SharpDisplay::isHardwareTransferRunning()) {
+            SMCR = _BV(SM1)|_BV(SE); // Power-down mode.
+            sei(); // The sleep instruction is executed before any interrupt.
+            sleep_cpu();
+            SMCR = 0;
+        }
+        sei();
+        KeyPad::setWakeUpEnabled(false);
+        // Let the timer interrupt refresh the display and check the keys.
+        if (DS3231::isAlarmPending()) {
+            DS3231::clearAlarms();
+            SharpDisplay::resumeAfterSleep(1);
+            ++elapsedSeconds;
+            TCNT2 = 0xff; // Refresh with the next timer tick.
+        } else {
+            TCNT2 = 0; // Check the keys after the contacts of a pressed key stopped bouncing.
         }
+        sleepUntilTimerInterrupt();
+    }
+}
+
+
+/// Wait a number of seconds, or until a key is pressed.
+///
+/// The alarm of the real time clock is used, if it is set. Otherwise,
+/// or if it could not be set, the timer 2 interrupt wakes up.
+///
+/// @param seconds The number of seconds to sleep.
+///
+void powerSave(uint16_t seconds)
+{
+    // A view may have left the power saving mode, and disabled the alarm.
+    if (!isPowerSavingMode(gOperationMode)) {
+        return;
+    }
+    if (gAlarmWakeUp) {
+        powerSaveWithAlarm(seconds);
+    } else {
+        powerSaveWithTimer(seconds);
+    }
+}
+
+
+/// Read the sensor, while sleeping in idle mode.
+///
+/// The sensor is read in the background, using the pin change interrupt
+/// to time the bits. The display refresh is paused meanwhile, because
+/// a long display interrupt would delay the timing of the bits. The
+/// overflow interrupt of timer 0 wakes the microcontroller every
+/// millisecond to advance the read.
+///
+/// All channels are read at once. If the last measurements are fresh,
+/// they are used without reading the sensors again.
+///
+/// @param dateTime The current time.
+/// @return The measurement of the first channel, all channels are in the cache.
+///
+DHT22::Measurement readMeasurement(const DateTime &dateTime)
+{
+    const uint32_t time = dateTime.toSecondsSince2000();
+    if (DHT22::isMeasurementFresh(time)) {
+        return DHT22::getCachedMeasurement();
+    }
+    SharpDisplay::setRefreshPaused(true);
+    DHT22::startRead(time);
+    while (!DHT22::isReadFinished()) {
+        SMCR = _BV(SE); // Idle mode, the timers keep running.
+        sleep_cpu();
+        SMCR = 0;
     }
+    SharpDisplay::setRefreshPaused(false);
+    return DHT22::getReadResult();
+}
+
+
+/// Create a log record with the cached measurements of all channels.
+///
+LogRecord createLogRecord(const DateTime &dateTime)
+{
+    float temperatures[SENSOR_CHANNEL_COUNT];
+    float humidities[SENSOR_CHANNEL_COUNT];
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        const DHT22::Measurement measurement = DHT22::getCachedMeasurement(channel);
+        temperatures[channel] = measurement.temperature;
+        humidities[channel] = measurement.humidity;
+    }
+    return LogRecord(dateTime, temperatures, humidities);
+}
+
+
+/// Store the time read in the background.
+///
+void setAsyncDateTime(const DateTime &dateTime)
+{
+    gAsyncDateTime = dateTime;
 }
 
 
@@ -90,8 +275,12 @@ void setup()
     // Initialize the key pad.
     KeyPad::begin();
 
-    // Initialize the display.
-    SharpDisplay::begin(11, 9, 10);
+    // Initialize the display, the software interface works with the default wiring.
+    const uint8_t *displayPins = cDisplayPins[gDisplayInterface];
+    if (!SharpDisplay::begin(displayPins[0], displayPins[1], displayPins[2], gDisplayInterface)) {
+        displayPins = cDisplayPins[SharpDisplay::SoftwareInterface];
+        SharpDisplay::begin(displayPins[0], displayPins[1], displayPins[2]);
+    }
     SharpDisplay::setFont(Fonts::getFontA());
     SharpDisplay::setInterruptCallback(&KeyPad::checkKeys);
     
@@ -101,12 +290,14 @@ void setup()
 
     // Initialize all libraries
     ViewManager::begin();
-    Wire.begin();
-    DHT22::begin(3);
+    TwiMaster::begin(cDefaultBusClock);
+    DHT22::begin(cSensorPins, SENSOR_CHANNEL_COUNT);
     SharpDisplay::writeText(PSTR("\x9e\n"));
 
     // Initialize the log system.
     SharpDisplay::writeText(PSTR("Log Sys... "));
+    // The storage uses the FRAM chip, if no other backend was selected.
+    FramStorage::setBusClock(cStorageBusClock);
     if (!Storage::begin()) {
         ViewManager::displayError(F("Storage\nProblem"));
     }
@@ -115,9 +306,13 @@ void setup()
 
     // Read all settings.
     Settings::begin();
+    LogSystem::setOverwriteOldest(Settings::getLogMode() == Settings::OverwriteOldest);
+    LogSystem::setRecordInterval(Settings::getIntervalInSeconds());
     
     SharpDisplay::writeText(PSTR("RTC... "));
-    DS3231::begin(2000); // Usage 2000-2199
+    DS3231::begin(2000, cRtcBusClock); // Usage 2000-2199
+    DS3231::setAlarmInterruptEnabled(cRtcAlarmWakeUp);
+    DS3231::disableAlarm(DS3231::Alarm1); // It stays enabled after a reset in a power saving mode.
     if (!DS3231::isRunning()) {
         ViewManager::displayError(F("RTC Problem"));
     }
@@ -145,8 +340,8 @@ void loop()
         if (++gDisplayInfoRefreshCount > 200) {
             gDisplayInfoRefreshCount = 0;
             // Read the time and sensor data.
-            measurement = DHT22::readTemperatureAndHumidity();
             dateTime = DS3231::getDateTime();
+            measurement = readMeasurement(dateTime);
             ViewManager::updateMeasurementDisplay(measurement, dateTime, ' ');
         }
     } else if (gOperationMode == FullScreenMode) {
@@ -155,14 +350,17 @@ void loop()
         delay(50);
     } else if (gOperationMode == RecordingMode) {
         // Power saving recording mode
+        // Read the time in the background, while the display is updated.
+        DS3231::getDateTimeAsync(&setAsyncDateTime);
         ViewManager::setNeedsDisplayUpdate(); // Update of the screen always required.
         ViewManager::loop();
+        TwiMaster::waitUntilIdle();
 
         // Check if we shall store a new record.
-        dateTime = DS3231::getDateTime();
+        dateTime = gAsyncDateTime;
         if (dateTime >= gNextRecordTime) {
-            measurement = DHT22::readTemperatureAndHumidity();
-            LogRecord logRecord(dateTime, measurement.temperature, measurement.humidity);
+            measurement = readMeasurement(dateTime);
+            const LogRecord logRecord = createLogRecord(dateTime);
             if (!LogSystem::appendRecord(logRecord)) {
                 ViewManager::setNextView(ViewManager::MemoryFullView);
                 setOperationMode(Application::MenuMode);
@@ -181,13 +379,19 @@ void loop()
         ViewManager::loop();
         
         dateTime = DS3231::getDateTime();
-        measurement = DHT22::readTemperatureAndHumidity();
+        measurement = readMeasurement(dateTime);
         ViewManager::updateMeasurementDisplay(measurement, dateTime, '\x84');
         powerSave(60); // Update in 1 minute intervals (except a key is pressed).
     }
 }
 
     
+void setDisplayInterface(SharpDisplay::Interface interface)
+{
+    gDisplayInterface = interface;
+}
+
+
 void resetNextRecordTime()
 {
     gNextRecordTime = DS3231::getDateTime().addSeconds(10);
@@ -196,6 +400,15 @@ void resetNextRecordTime()
     
 void setOperationMode(OperationMode mode)
 {
+    // The alarm is only set when a power saving mode is entered, and
+    // disabled when it is left, instead of with each sleep.
+    // If the alarm can not be set, the timer wakes up instead.
+    if (cRtcAlarmWakeUp && isPowerSavingMode(mode) && !isPowerSavingMode(gOperationMode)) {
+        gAlarmWakeUp = DS3231::setAlarm(DS3231::Alarm1, DateTime(), DS3231::MatchNothing);
+    } else if (gAlarmWakeUp && !isPowerSavingMode(mode)) {
+        DS3231::disableAlarm(DS3231::Alarm1);
+        gAlarmWakeUp = false;
+    }
     gOperationMode = mode;
     gDisplayInfoRefreshCount = 201;
     switch (mode) {
@@ -20,6 +20,8 @@
 //
 
 
+#include "SharpDisplay.h"
+
 #include <Arduino.h>
 
 
@@ -48,6 +50,15 @@ void setup();
 ///
 void loop();
 
+/// Select the interface of the display.
+///
+/// Call this before setup(), the default is the interface from the
+/// configuration. The display has to be wired for this interface, see
+/// config.h. If the interface can not be used, setup() falls back to
+/// the software interface.
+///
+void setDisplayInterface(SharpDisplay::Interface interface);
+
 /// Set the next record time to the current time + 10 seconds.
 ///
 void resetNextRecordTime();
@@ -0,0 +1,145 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "ChartView.h"
+
+
+#include "Application.h"
+#include "LogSystem.h"
+#include "SharpDisplay.h"
+#include "ViewManager.h"
+
+
+namespace lr {
+namespace ChartView {
+
+
+// The first row of the chart.
+static const uint8_t cChartFirstRow = 1;
+
+// The number of rows of the chart.
+static const uint8_t cChartRowCount = 10;
+
+
+static bool gShowHumidity = false; ///< If the humidity is shown instead of the temperature.
+
+
+void viewWillAppear()
+{
+    Application::setOperationMode(Application::FullScreenMode);
+    SharpDisplay::setChartRows(cChartFirstRow, cChartRowCount);
+}
+
+
+// Get the shown value of a record.
+inline float getValue(const LogRecord &logRecord)
+{
+    return gShowHumidity ? logRecord.getHumidity() : logRecord.getTemperature();
+}
+
+
+// Draw the last records as chart, one record in each pixel column.
+//
+// @param minimum The variable to store the minimum value.
+// @param maximum The variable to store the maximum value.
+//
+void drawChart(float &minimum, float &maximum)
+{
+    const uint8_t width = SharpDisplay::getChartWidth();
+    const uint8_t height = SharpDisplay::getChartHeight();
+    const uint32_t numberOfRecords = LogSystem::currentNumberOfRecords();
+    const uint8_t count = (numberOfRecords < width) ? numberOfRecords : width;
+    const uint32_t firstRecord = numberOfRecords - count;
+    // Get the range of the values first.
+    minimum = NAN;
+    maximum = NAN;
+    for (uint8_t i = 0; i < count; ++i) {
+        const float value = getValue(LogSystem::getLogRecord(firstRecord + i));
+        if (!isnan(value)) {
+            if (isnan(minimum) || value < minimum) {
+                minimum = value;
+            }
+            if (isnan(maximum) || value > maximum) {
+                maximum = value;
+            }
+        }
+    }
+    // The display draws a line from the previous value to each value.
+    SharpDisplay::clearChart();
+    // A constant value is drawn in the middle of the chart.
+    const float range = (maximum > minimum) ? (maximum - minimum) : 0.0f;
+    for (uint8_t i = 0; i < count; ++i) {
+        const float value = getValue(LogSystem::getLogRecord(firstRecord + i));
+        if (isnan(value)) {
+            continue;
+        }
+        uint8_t y = height / 2;
+        if (range > 0.0f) {
+            y = (height - 1) - static_cast<uint8_t>((value - minimum) * (height - 1) / range + 0.5f);
+        }
+        SharpDisplay::setChartColumn(width - count + i, y);
+    }
+}
+
+
+void updateDisplay()
+{
+    float minimum;
+    float maximum;
+    drawChart(minimum, maximum);
+    SharpDisplay::setTextInverse(false);
+    if (gShowHumidity) {
+        SharpDisplay::setLineText(0, PSTR("Humidity %"));
+    } else {
+        SharpDisplay::setLineText(0, PSTR("Temp. \x7f""C"));
+    }
+    if (isnan(minimum)) {
+        SharpDisplay::setLineText(11, PSTR("No Records"));
+    } else {
+        String rangeText = String(minimum, 1);
+        rangeText += '-';
+        rangeText += String(maximum, 1);
+        SharpDisplay::setLineText(11, rangeText);
+    }
+}
+
+
+void handleKey(KeyPad::Key key)
+{
+    switch (key) {
+        case KeyPad::Up:
+        case KeyPad::Down:
+        case KeyPad::Right:
+            gShowHumidity = !gShowHumidity;
+            break;
+            
+        case KeyPad::Left:
+            SharpDisplay::setChartRows(0, 0);
+            ViewManager::setNextView(ViewManager::MainMenuView);
+            return;
+            
+        default:
+            break;
+    }
+    ViewManager::setNeedsDisplayUpdate();
+}
+
+
+}
+}
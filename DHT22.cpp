@@ -26,147 +26,430 @@ namespace lr {
 namespace DHT22 {
 
 
-static uint8_t gPin; ///< The pin to read from.
-static uint8_t gPinMask; ///< The bit for the pin.
-static uint8_t gPinPort; ///< The port for the pin.
-static uint32_t gPulseTimeout; ///< The maximum count to wait for a pulse.
+/// The state of the read of the current channel.
+///
+enum State : uint8_t {
+    Idle, ///< No read is running.
+    StartSignal, ///< The line is pulled low to start a read.
+    Receiving, ///< The edges from the sensor are timed.
+    Finished, ///< All bits were received.
+    Failed ///< The sensor did not respond or stopped sending.
+};
 
-    
-/// The result for measuring a pulse.
+
+/// A sensor channel.
 ///
-enum PulseResult : uint8_t {
-    PulseHigh,
-    PulseLow,
-    Timeout
+struct Channel {
+    uint8_t pin; ///< The pin of the sensor.
+    uint8_t pinMask; ///< The bit for the pin.
+    uint8_t pinPort; ///< The port for the pin.
+    uint16_t startSignalMillis; ///< The time when the start signal began, relative to the start of the read.
+    Measurement measurement; ///< The measurement of the last read.
+    ReadTiming timing; ///< The timing of the last read.
 };
 
     
+static const uint8_t cStartSignalMillis = 20; ///< The duration of the start signal.
+static const uint8_t cChannelIntervalMillis = 6; ///< The time between the start signals of two channels.
+static const uint8_t cBitCount = 40; ///< The number of bits to read.
+static const uint8_t cFirstBitEdge = 2; ///< The falling edge which ends the first bit.
+static const uint8_t cResponseTimeoutMicros = 200; ///< The maximum time until the response (20-40us).
+static const uint8_t cEdgeTimeoutMicros = 200; ///< The maximum time between two falling edges.
+static const uint8_t cResponseMinimumMicros = 120; ///< The minimum period of the response (80+80us).
+static const uint8_t cBitMinimumMicros = 60; ///< The minimum period of a zero bit (50+26us).
+static const uint8_t cBitOneMinimumMicros = 100; ///< The minimum period of a one bit (50+70us).
+static const uint8_t cBitMaximumMicros = 150; ///< The maximum period of a one bit.
+static const uint8_t cTimerTicksPerMicrosecond = F_CPU/8/1000000; ///< Timer 1 runs with prescaler 8.
+
+static Channel gChannels[cMaximumChannelCount]; ///< All sensor channels.
+static uint8_t gChannelCount; ///< The number of channels.
+static uint8_t gChannel; ///< The channel which is received next, or gChannelCount if the read has finished.
+static uint8_t gNextStartSignalChannel; ///< The next channel to start the signal.
+static uint8_t gReceivePinMask; ///< The bit for the pin of the received channel.
+static uint8_t gReceivePinPort; ///< The port for the pin of the received channel.
+static volatile State gState; ///< The state of the read of the current channel.
+static uint32_t gReadStartMillis; ///< The time when the read started.
+static uint16_t gLastEdgeTicks; ///< The timer value of the last falling edge.
+static uint8_t gReadData[5]; ///< 5 bytes of read data.
+static ReadTiming gReadTiming; ///< The timing of the current read.
+static uint32_t gReadTime; ///< The time of the current read in seconds.
+static uint8_t gMaximumMeasurementAge = 2; ///< The maximum age of a cached measurement in seconds.
+static bool gHasCachedMeasurement; ///< If there are measurements in the cache.
+static uint32_t gCachedMeasurementTime; ///< The time of the cached measurements in seconds.
+
+    
 void begin(uint8_t pin)
 {
-    gPin = pin;
-    gPinMask = digitalPinToBitMask(gPin);
-    gPinPort = digitalPinToPort(gPin);
-    gPulseTimeout = microsecondsToClockCycles(1000); // > 1ms timeout.
-    pinMode(gPin, INPUT);
-    digitalWrite(gPin, HIGH);
+    begin(&pin, 1);
 }
 
 
-/// Read a single pulse from the pin.
-///
-PulseResult getPulse()
+void begin(const uint8_t *pins, uint8_t channelCount)
 {
-    uint32_t lowCount = 0;
-    uint32_t highCount = 0;
-    while ((*portInputRegister(gPinPort) & gPinMask) == 0) {
-        if (++lowCount > gPulseTimeout) {
-            return Timeout;
-        }
+    gChannelCount = min(channelCount, cMaximumChannelCount);
+    for (uint8_t i = 0; i < gChannelCount; ++i) {
+        Channel &channel = gChannels[i];
+        channel.pin = pins[i];
+        channel.pinMask = digitalPinToBitMask(channel.pin);
+        channel.pinPort = digitalPinToPort(channel.pin);
+        pinMode(channel.pin, INPUT);
+        digitalWrite(channel.pin, HIGH);
     }
-    while ((*portInputRegister(gPinPort) & gPinMask) != 0) {
-        if (++highCount > gPulseTimeout) {
-            return Timeout;
-        }
+    gChannel = gChannelCount;
+    gState = Idle;
+    gHasCachedMeasurement = false;
+}
+
+
+uint8_t getChannelCount()
+{
+    return gChannelCount;
+}
+
+
+/// Enable or disable the pin change interrupt for a pin.
+///
+void setPinChangeInterruptEnabled(uint8_t pin, bool enabled)
+{
+    if (enabled) {
+        *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+        PCIFR = _BV(digitalPinToPCICRbit(pin)); // Ignore any previous change.
+        PCICR |= _BV(digitalPinToPCICRbit(pin));
+    } else {
+        *digitalPinToPCMSK(pin) &= ~_BV(digitalPinToPCMSKbit(pin));
     }
-    return (highCount>lowCount) ? PulseHigh : PulseLow;
 }
 
 
-Measurement readTemperatureAndHumidity()
+/// Start timer 1 as time base for the edges.
+///
+void startTimer()
 {
-    Measurement measurement = {NAN, NAN};
-    
-    // 5 bytes of read data.
-    uint8_t readData[5];
-    memset(readData, 0, 5);
-    
-    // Start time critical code
-    noInterrupts();
-    
-    // Trigger the start of a new read.
-    digitalWrite(gPin, HIGH);
-    delay(250);
-    pinMode(gPin, OUTPUT);
-    digitalWrite(gPin, LOW);
-    delay(20); // Data low for 20ms.
-    digitalWrite(gPin, HIGH);
-    delayMicroseconds(40);
-    // Back observing the line for the data.
-    pinMode(gPin, INPUT);
-    delayMicroseconds(10);
-    
-    // Read and ignore the initial pulse from the sensor.
-    if (getPulse() == Timeout) {
-#ifdef LR_DHT22_DEBUG
-        Serial.println(F("Timeout for initial pulse."));
-#endif
-        goto END_READ;
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TIMSK1 = 0;
+    TCNT1 = 0;
+    TCCR1B = _BV(CS11); // Normal mode, prescaler 8.
+}
+
+
+/// Stop timer 1 and the timeout.
+///
+void stopTimer()
+{
+    TIMSK1 = 0;
+    TCCR1B = 0;
+}
+
+
+/// Set the timeout for the next edge.
+///
+/// If there is no edge until then, the compare match interrupt ends
+/// the read. This lets a read fail a few hundred microseconds after
+/// the last edge, instead of waiting for a fixed time.
+///
+void setEdgeTimeout(uint16_t now, uint8_t timeoutMicros)
+{
+    OCR1A = now + (static_cast<uint16_t>(timeoutMicros) * cTimerTicksPerMicrosecond);
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 = _BV(OCIE1A);
+}
+
+
+/// End the read with the given error.
+///
+void endRead(ReadError error)
+{
+    setPinChangeInterruptEnabled(gChannels[gChannel].pin, false);
+    stopTimer();
+    gReadTiming.error = error;
+    gState = ((error == NoError) ? Finished : Failed);
+}
+
+
+/// Check the checksum of the read data.
+///
+bool isChecksumValid()
+{
+    return gReadData[4] == ((gReadData[0]+gReadData[1]+gReadData[2]+gReadData[3])&0xff);
+}
+
+
+/// Process a change of the pin.
+///
+/// The sensor starts the response with a falling edge, followed by a
+/// 80us low and 80us high pulse. Each bit is a 50us low pulse, followed
+/// by a 26us high pulse for a zero or a 70us high pulse for a one. So
+/// the period between two falling edges is the value of the bit.
+///
+void onPinChange()
+{
+    if (gState != Receiving || (*portInputRegister(gReceivePinPort) & gReceivePinMask) != 0) {
+        return; // Only falling edges are timed.
     }
-    
-    // Now read all 40 bits.
-    for (uint8_t i = 0; i < 5; ++i) {
-        for (uint8_t j = 0; j < 8; ++j) {
-            switch (getPulse()) {
-                case PulseHigh:
-                    readData[i] <<= 1;
-                    readData[i] |= 1;
-                    break;
-                case PulseLow:
-                    readData[i] <<= 1;
-                    break;
-                case Timeout:
-#ifdef LR_DHT22_DEBUG
-                    Serial.print(F("Timeout for reading byte "));
-                    Serial.print(i);
-                    Serial.print(F(" bit "));
-                    Serial.println(j);
-#endif
-                    goto END_READ;
-            }
+    const uint16_t now = TCNT1;
+    const uint16_t periodTicks = now - gLastEdgeTicks;
+    const uint8_t period = (periodTicks < (0xff*cTimerTicksPerMicrosecond)) ? (periodTicks / cTimerTicksPerMicrosecond) : 0xff;
+    gLastEdgeTicks = now;
+    const uint8_t edge = gReadTiming.edgeCount++;
+    if (edge == 0) {
+        // The start of the response.
+    } else if (edge == 1) {
+        gReadTiming.responseMicros = period;
+        if (period < cResponseMinimumMicros) {
+            endRead(InvalidPulse);
+            return;
+        }
+    } else {
+        if (period < cBitMinimumMicros || period > cBitMaximumMicros) {
+            endRead(InvalidPulse);
+            return;
+        }
+        const uint8_t bit = edge - cFirstBitEdge;
+        uint8_t &data = gReadData[bit >> 3];
+        data <<= 1;
+        if (period >= cBitOneMinimumMicros) {
+            data |= 1;
+            gReadTiming.minimumOneMicros = min(gReadTiming.minimumOneMicros, period);
+            gReadTiming.maximumOneMicros = max(gReadTiming.maximumOneMicros, period);
+        } else {
+            gReadTiming.minimumZeroMicros = min(gReadTiming.minimumZeroMicros, period);
+            gReadTiming.maximumZeroMicros = max(gReadTiming.maximumZeroMicros, period);
+        }
+        if (bit == (cBitCount-1)) {
+            endRead(isChecksumValid() ? NoError : ChecksumError);
+            return;
         }
     }
+    setEdgeTimeout(now, cEdgeTimeoutMicros);
+}
 
-#ifdef LR_DHT22_DEBUG
-    Serial.print(F("Read bytes: 0x"));
-    Serial.print(readData[0], HEX);
-    Serial.print(F(", 0x"));
-    Serial.print(readData[1], HEX);
-    Serial.print(F(", 0x"));
-    Serial.print(readData[2], HEX);
-    Serial.print(F(", 0x"));
-    Serial.print(readData[3], HEX);
-    Serial.print(F(", 0x"));
-    Serial.print(readData[4], HEX);
-#endif
-    
-    // Check the checksum
-    if (readData[4] != ((readData[0]+readData[1]+readData[2]+readData[3])&0xff)) {
-#ifdef LR_DHT22_DEBUG
-        Serial.println(F("Checksum does not match."));
-#endif
-        goto END_READ;
+
+/// Process the timeout for the next edge.
+///
+void onEdgeTimeout()
+{
+    if (gState == Receiving) {
+        endRead((gReadTiming.edgeCount == 0) ? NoResponse : PulseTimeout);
     }
-    
-    // Convert the read bits into temperature and humidity
-    measurement.temperature = (static_cast<uint16_t>(readData[2]&0x7f) << 8) + readData[3];
+}
+
+
+/// Pull the line of a channel low, to start its signal.
+///
+void startSignal(uint8_t channelIndex, uint16_t elapsedMillis)
+{
+    Channel &channel = gChannels[channelIndex];
+    pinMode(channel.pin, OUTPUT);
+    digitalWrite(channel.pin, LOW);
+    channel.startSignalMillis = elapsedMillis;
+}
+
+
+/// Release the line of the current channel and observe it for the response.
+///
+void startReceive()
+{
+    const Channel &channel = gChannels[gChannel];
+    memset(gReadData, 0, 5);
+    memset(&gReadTiming, 0, sizeof(ReadTiming));
+    gReadTiming.minimumZeroMicros = 0xff;
+    gReadTiming.minimumOneMicros = 0xff;
+    gReceivePinMask = channel.pinMask;
+    gReceivePinPort = channel.pinPort;
+    startTimer();
+    gLastEdgeTicks = 0;
+    gState = Receiving;
+    digitalWrite(channel.pin, HIGH);
+    pinMode(channel.pin, INPUT);
+    setPinChangeInterruptEnabled(channel.pin, true);
+    setEdgeTimeout(TCNT1, cResponseTimeoutMicros);
+}
+
+
+/// Convert the read data into a measurement.
+///
+/// The checksum was already checked at the end of the read.
+///
+Measurement convertReadData()
+{
+    Measurement measurement;
+    measurement.temperature = (static_cast<uint16_t>(gReadData[2]&0x7f) << 8) + gReadData[3];
     measurement.temperature /= 10.0f;
-    if ((readData[2] & 0x80) != 0) {
+    if ((gReadData[2] & 0x80) != 0) {
         measurement.temperature *= -1.0f;
     }
-    measurement.humidity = (static_cast<uint16_t>(readData[0]&0x7f) << 8) + readData[1];
+    measurement.humidity = (static_cast<uint16_t>(gReadData[0]&0x7f) << 8) + gReadData[1];
     measurement.humidity /= 10.0f;
-    if ((readData[0] & 0x80) != 0) {
+    if ((gReadData[0] & 0x80) != 0) {
         measurement.humidity *= -1.0f;
     }
-    
-END_READ:
-    // End time critical code
-    interrupts();
-    
     return measurement;
 }
 
 
+/// Store the result of the current channel.
+///
+void storeResult()
+{
+    Channel &channel = gChannels[gChannel];
+    channel.timing = gReadTiming;
+    if (gState == Finished) {
+        channel.measurement = convertReadData();
+    } else {
+        channel.measurement.temperature = NAN;
+        channel.measurement.humidity = NAN;
+    }
+    
+#ifdef LR_DHT22_DEBUG
+    Serial.print(F("Channel "));
+    Serial.print(gChannel);
+    if (gState == Finished) {
+        Serial.print(F(" read bytes: 0x"));
+        Serial.print(gReadData[0], HEX);
+        Serial.print(F(", 0x"));
+        Serial.print(gReadData[1], HEX);
+        Serial.print(F(", 0x"));
+        Serial.print(gReadData[2], HEX);
+        Serial.print(F(", 0x"));
+        Serial.print(gReadData[3], HEX);
+        Serial.print(F(", 0x"));
+        Serial.println(gReadData[4], HEX);
+    } else {
+        Serial.print(F(" read failed with error "));
+        Serial.print(gReadTiming.error);
+        Serial.print(F(" after edge "));
+        Serial.println(gReadTiming.edgeCount);
+    }
+#endif
+}
+
+
+void startRead(uint32_t time)
+{
+    if (gChannel < gChannelCount) {
+        setPinChangeInterruptEnabled(gChannels[gChannel].pin, false);
+    }
+    stopTimer();
+    gChannel = 0;
+    gNextStartSignalChannel = 0;
+    gState = StartSignal;
+    gReadStartMillis = millis();
+    gReadTime = time;
+    gHasCachedMeasurement = false;
+    // Pull the line of the first channel low to start a new read.
+    startSignal(gNextStartSignalChannel++, 0);
+}
+
+
+bool isReadFinished()
+{
+    if (gChannel >= gChannelCount) {
+        return true;
+    }
+    const uint32_t elapsed = millis() - gReadStartMillis;
+    const uint16_t elapsedMillis = (elapsed < 0xffff) ? static_cast<uint16_t>(elapsed) : 0xffff;
+    // Start the signals of the following channels, while the current
+    // one is still in its start signal or receiving.
+    while (gNextStartSignalChannel < gChannelCount &&
+        elapsedMillis >= static_cast<uint16_t>(gNextStartSignalChannel) * cChannelIntervalMillis) {
+        startSignal(gNextStartSignalChannel++, elapsedMillis);
+    }
+    switch (gState) {
+        case StartSignal:
+            if (gChannel < gNextStartSignalChannel &&
+                (elapsedMillis - gChannels[gChannel].startSignalMillis) >= cStartSignalMillis) {
+                startReceive();
+            }
+            return false;
+            
+        case Receiving:
+            return false; // The interrupts finish the read of this channel.
+            
+        default:
+            storeResult();
+            ++gChannel;
+            if (gChannel < gChannelCount) {
+                gState = StartSignal;
+                return false;
+            }
+            gState = Idle;
+            gHasCachedMeasurement = true;
+            gCachedMeasurementTime = gReadTime;
+            return true;
+    }
+}
+
+
+Measurement getReadResult(uint8_t channel)
+{
+    // The cache is cleared at the start of a read and filled at its end.
+    return getCachedMeasurement(channel);
+}
+
+
+void setMaximumMeasurementAge(uint8_t seconds)
+{
+    gMaximumMeasurementAge = seconds;
 }
+
+
+bool isMeasurementFresh(uint32_t time)
+{
+    // A time before the measurement happens if the clock is adjusted.
+    return gHasCachedMeasurement && time >= gCachedMeasurementTime && (time - gCachedMeasurementTime) <= gMaximumMeasurementAge;
 }
 
+
+Measurement getCachedMeasurement(uint8_t channel)
+{
+    if (!gHasCachedMeasurement || channel >= gChannelCount) {
+        Measurement measurement = {NAN, NAN};
+        return measurement;
+    }
+    return gChannels[channel].measurement;
+}
+
+
+ReadTiming getReadTiming(uint8_t channel)
+{
+    ReadTiming timing = {ReadNotFinished, 0, 0, 0, 0, 0, 0};
+    if (gHasCachedMeasurement && channel < gChannelCount) {
+        timing = gChannels[channel].timing;
+    }
+    return timing;
+}
+
+
+Measurement readTemperatureAndHumidity(uint32_t time)
+{
+    if (!isMeasurementFresh(time)) {
+        startRead(time);
+        while (!isReadFinished()) {
+        }
+    }
+    return getCachedMeasurement();
+}
+
+
+}
+}
+
+
+// All pin change interrupts are handled the same way, only the pin of the
+// received channel is enabled.
+ISR(PCINT0_vect)
+{
+    lr::DHT22::onPinChange();
+}
+ISR(PCINT1_vect, ISR_ALIASOF(PCINT0_vect));
+ISR(PCINT2_vect, ISR_ALIASOF(PCINT0_vect));
+
+
+// The timeout while waiting for an edge.
+ISR(TIMER1_COMPA_vect)
+{
+    lr::DHT22::onEdgeTimeout();
+}
+
+
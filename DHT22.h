@@ -20,6 +20,8 @@
 //
 
 
+#include "config.h"
+
 #include <Arduino.h>
 
 
@@ -43,16 +45,137 @@ struct Measurement {
     float humidity;
 };
 
+
+/// The result of a read.
+///
+enum ReadError : uint8_t {
+    NoError, ///< The read was successful.
+    NoResponse, ///< The sensor did not respond to the start signal.
+    PulseTimeout, ///< The sensor stopped sending in the middle of the data.
+    InvalidPulse, ///< A pulse was too short or too long.
+    ChecksumError, ///< All bits were read, but the checksum does not match.
+    ReadNotFinished, ///< No read was started or it is still running.
+};
+
+
+/// The timing of the last read.
+///
+/// All periods are measured between two falling edges, in microseconds.
+/// A zero bit is nominal 76us, a one bit 120us and the response 160us.
+///
+struct ReadTiming {
+    ReadError error; ///< The result of the read.
+    uint8_t edgeCount; ///< The number of falling edges received.
+    uint8_t responseMicros; ///< The period of the response before the first bit.
+    uint8_t minimumZeroMicros; ///< The shortest zero bit.
+    uint8_t maximumZeroMicros; ///< The longest zero bit.
+    uint8_t minimumOneMicros; ///< The shortest one bit.
+    uint8_t maximumOneMicros; ///< The longest one bit.
+};
+
+    
+/// The maximum number of sensor channels.
+///
+const uint8_t cMaximumChannelCount = SENSOR_CHANNEL_COUNT;
+
     
-/// Initialize the library
+/// Initialize the library with one sensor.
+///
+/// The bits from the sensor are timed using the pin change interrupt,
+/// which works on any pin. This library uses all pin change interrupt
+/// vectors, and timer 1 while reading.
 ///
 void begin(uint8_t pin);
 
-/// Read the temperature and humidity
+/// Initialize the library with one sensor for each channel.
+///
+/// @param pins The pins of the sensors, one for each channel.
+/// @param channelCount The number of channels, up to cMaximumChannelCount.
+///
+void begin(const uint8_t *pins, uint8_t channelCount);
+
+/// Get the number of channels.
+///
+uint8_t getChannelCount();
+
+/// Start a new read of all channels in the background.
+///
+/// The start signal takes 20ms, the transfer of the bits about 5ms.
+/// The start signals of the channels overlap, each channel starts 6ms
+/// after the previous one and is received while the next one is still
+/// in its start signal. So reading N channels takes 20+6*N ms instead
+/// of 25*N ms.
+///
+/// Interrupts stay enabled the whole time. Call isReadFinished()
+/// regularly until it returns true, at least every few milliseconds.
+/// A running read is restarted.
+///
+/// @param time The current time in seconds, which is stored with the
+///    measurement in the cache. Use a clock which also runs while the
+///    microcontroller sleeps, like the seconds since 2000 of the RTC.
+///
+void startRead(uint32_t time);
+
+/// Check if the read has finished.
+///
+/// This advances the read after the start signal.
+///
+/// @return true if the read of all channels has finished or failed, or if no read was started.
+///
+bool isReadFinished();
+
+/// Get the result of the last read.
+///
+/// The results of all channels are stored in the measurement cache.
+///
+/// @param channel The channel, the first one by default.
+/// @return The measurement, with NaN values if the read failed.
+///
+Measurement getReadResult(uint8_t channel = 0);
+
+/// Set the maximum age of a cached measurement.
+///
+/// The sensor needs at least two seconds between two reads, which is
+/// the default.
+///
+/// @param seconds The maximum age in seconds.
+///
+void setMaximumMeasurementAge(uint8_t seconds);
+
+/// Check if the cached measurements are fresh.
+///
+/// All channels are read together, so they share the time in the cache.
+///
+/// @param time The current time in seconds, from the same clock as for startRead().
+/// @return true if there are measurements in the cache, which are not older than the maximum age.
+///
+bool isMeasurementFresh(uint32_t time);
+
+/// Get the cached measurement.
+///
+/// @param channel The channel, the first one by default.
+/// @return The measurement of the last finished read, with NaN values if there is none or it failed.
+///
+Measurement getCachedMeasurement(uint8_t channel = 0);
+
+/// Get the timing of the last read.
+///
+/// Use this to diagnose problems with the sensor or its line.
+///
+/// @param channel The channel, the first one by default.
+///
+ReadTiming getReadTiming(uint8_t channel = 0);
+
+/// Read the temperature and humidity of all channels.
+///
+/// The temperature is read in celsius. If the cached measurements are
+/// fresh, they are used. Otherwise this starts a read and waits until it
+/// has finished. Interrupts stay enabled while waiting.
 ///
-/// The temperature is read in celsius.
+/// @param time The current time in seconds, see startRead().
+/// @return The measurement of the first channel, the other channels are in the cache.
 ///
-Measurement readTemperatureAndHumidity();
+Measurement readTemperatureAndHumidity(uint32_t time);
 
 
 }
@@ -20,7 +20,11 @@
 #include "DS3231.h"
 
 
-#include <Wire.h>
+#include "TwiMaster.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <string.h>
 
 
 namespace lr {
@@ -32,11 +36,39 @@ static const uint8_t cChipAddress = 0x68;
     
 // The used registers
 static const uint8_t cSecondsRegister = 0x00;
+static const uint8_t cAlarm1Register = 0x07;
+static const uint8_t cAlarm2Register = 0x0b;
 static const uint8_t cControlRegister = 0x0e;
+static const uint8_t cStatusRegister = 0x0f;
 static const uint8_t cTemperatureRegister = 0x11;
 
+// The bits in the control and status register. The interrupt enable bits
+// and the flags of the alarms match the values of the Alarm enum.
+static const uint8_t cInterruptControlBit = _BV(2);
+static const uint8_t cAlarmBits = Alarm1|Alarm2;
+static const uint8_t cOscillatorStopFlag = _BV(7);
+static const uint8_t cEnable32kHzBit = _BV(3);
+
+// The bit in the alarm registers to ignore the value.
+static const uint8_t cAlarmMaskBit = _BV(7);
+
+// The pin connected to the INT/SQW output, which is INT0.
+static const uint8_t cInterruptPin = 2;
+
 // The year base.
 static uint16_t gYearBase;
+
+// The transfer for all synchronous calls.
+static TwiMaster::Transfer gTransfer;
+
+// The transfer, buffer and callback to read the time in the background.
+static TwiMaster::Transfer gDateTimeTransfer;
+static uint8_t gDateTimeRegisters[7];
+static DateTimeCallback gDateTimeCallback;
+
+// The state of the alarm interrupt.
+static bool gAlarmInterruptEnabled;
+static volatile bool gAlarmPending;
  
     
 // Function to convert BCD format into binary format.
@@ -53,28 +85,71 @@ static inline uint8_t convertBinToBcd(const uint8_t bin)
 }
 
     
-void begin(uint16_t yearBase)
+// Prepare a transfer to the chip.
+//
+// @param transfer The transfer to prepare.
+// @param firstRegister The first register to read or write.
+// @param data The buffer for the data.
+// @param size The number of registers to read or write.
+// @param read If the registers are read.
+//
+static void prepareTransfer(TwiMaster::Transfer *transfer, uint8_t firstRegister, uint8_t *data, uint8_t size, bool read)
 {
-    gYearBase = yearBase;
+    memset(transfer, 0, sizeof(TwiMaster::Transfer));
+    transfer->address = cChipAddress;
+    transfer->command[0] = firstRegister;
+    transfer->commandSize = 1;
+    if (read) {
+        transfer->readData = data;
+    } else {
+        transfer->writeData = data;
+    }
+    transfer->dataSize = size;
 }
 
-    
-DateTime getDateTime()
+
+// Read a single register.
+//
+// @return The value of the register, or zero if the transfer failed.
+//
+static bool readRegister(uint8_t address, uint8_t &value)
+{
+    prepareTransfer(&gTransfer, address, &value, 1, true);
+    return TwiMaster::execute(&gTransfer);
+}
+
+
+// Write a single register.
+//
+static bool writeRegister(uint8_t address, uint8_t value)
 {
-    // Address the seconds register to read this plus
-    // all subsequent registers for the time.
-    Wire.beginTransmission(cChipAddress);
-    Wire.write(cSecondsRegister);
-    Wire.endTransmission();
-    // Read the initial 7 registers.
-    Wire.requestFrom(cChipAddress, 7u);
-    const uint8_t seconds = Wire.read();
-    const uint8_t minutes = Wire.read();
-    const uint8_t hours = Wire.read();
-    const uint8_t dayOfWeek = Wire.read();
-    const uint8_t day = Wire.read();
-    const uint8_t month = Wire.read();
-    const uint8_t year = Wire.read();
+    prepareTransfer(&gTransfer, address, &value, 1, false);
+    return TwiMaster::execute(&gTransfer);
+}
+
+
+// Called from the interrupt if the INT/SQW output is low.
+//
+static void onAlarmInterrupt()
+{
+    // The output stays low until the alarm is cleared, so the low level
+    // interrupt is disabled until then.
+    EIMSK &= ~_BV(INT0);
+    gAlarmPending = true;
+}
+
+
+// Convert the values of the time registers into a date/time.
+//
+static DateTime convertRegistersToDateTime(const uint8_t *registers)
+{
+    const uint8_t seconds = registers[0];
+    const uint8_t minutes = registers[1];
+    const uint8_t hours = registers[2];
+    const uint8_t dayOfWeek = registers[3];
+    const uint8_t day = registers[4];
+    const uint8_t month = registers[5];
+    const uint8_t year = registers[6];
     // Convert these values into a date object.
     return DateTime::fromUncheckedValues(
         static_cast<uint16_t>(convertBcdToBin(year))+((month&_BV(7))!=0?(gYearBase+100):gYearBase),
@@ -86,6 +161,48 @@ DateTime getDateTime()
         dayOfWeek&0x7);
 }
 
+
+// Called at the end of the transfer to read the time in the background.
+//
+static void onDateTimeTransferFinished(TwiMaster::Transfer *transfer)
+{
+    if (transfer->status != TwiMaster::Done) {
+        memset(gDateTimeRegisters, 0, sizeof(gDateTimeRegisters));
+    }
+    gDateTimeCallback(convertRegistersToDateTime(gDateTimeRegisters));
+}
+
+    
+void begin(uint16_t yearBase, uint32_t clock)
+{
+    gYearBase = yearBase;
+    TwiMaster::setDeviceClock(cChipAddress, clock);
+    gDateTimeTransfer.status = TwiMaster::Done;
+}
+
+    
+DateTime getDateTime()
+{
+    // Read the seconds register plus all subsequent registers for the time.
+    uint8_t registers[7];
+    prepareTransfer(&gTransfer, cSecondsRegister, registers, sizeof(registers), true);
+    if (!TwiMaster::execute(&gTransfer)) {
+        memset(registers, 0, sizeof(registers));
+    }
+    return convertRegistersToDateTime(registers);
+}
+
+
+void getDateTimeAsync(DateTimeCallback callback)
+{
+    // Wait for a previous request, because the buffer is shared.
+    TwiMaster::waitFor(&gDateTimeTransfer);
+    prepareTransfer(&gDateTimeTransfer, cSecondsRegister, gDateTimeRegisters, sizeof(gDateTimeRegisters), true);
+    gDateTimeTransfer.callback = &onDateTimeTransferFinished;
+    gDateTimeCallback = callback;
+    TwiMaster::queue(&gDateTimeTransfer);
+}
+
     
 void setDateTime(const DateTime &dateTime)
 {
@@ -95,37 +212,29 @@ void setDateTime(const DateTime &dateTime)
         return; // Ignore this call.
     }
     // Prepare all registers which will be written
-    const uint8_t seconds = convertBinToBcd(dateTime.getSecond());
-    const uint8_t minutes = convertBinToBcd(dateTime.getMinute());
-    const uint8_t hours = convertBinToBcd(dateTime.getHour());
-    const uint8_t dayOfWeek = dateTime.getDayOfWeek();
-    const uint8_t day = convertBinToBcd(dateTime.getDay());
-    const uint8_t month = convertBinToBcd(dateTime.getMonth()) |
+    uint8_t registers[7];
+    registers[0] = convertBinToBcd(dateTime.getSecond());
+    registers[1] = convertBinToBcd(dateTime.getMinute());
+    registers[2] = convertBinToBcd(dateTime.getHour());
+    registers[3] = dateTime.getDayOfWeek();
+    registers[4] = convertBinToBcd(dateTime.getDay());
+    registers[5] = convertBinToBcd(dateTime.getMonth()) |
         (dateTime.getYear()>=(gYearBase+100)?_BV(7):0);
-    const uint8_t year = convertBinToBcd(dateTime.getYear()%100);
+    registers[6] = convertBinToBcd(dateTime.getYear()%100);
     // Write the prepared values into the register
-    Wire.beginTransmission(cChipAddress);
-    Wire.write(cSecondsRegister);
-    Wire.write(seconds);
-    Wire.write(minutes);
-    Wire.write(hours);
-    Wire.write(dayOfWeek);
-    Wire.write(day);
-    Wire.write(month);
-    Wire.write(year);
-    Wire.endTransmission();
+    prepareTransfer(&gTransfer, cSecondsRegister, registers, sizeof(registers), false);
+    TwiMaster::execute(&gTransfer);
 }
 
     
 bool isRunning()
 {
-    // Address the control register.
-    Wire.beginTransmission(cChipAddress);
-    Wire.write(cControlRegister);
-    Wire.endTransmission();
-    // Read this register (1 byte).
-    Wire.requestFrom(cChipAddress, 1u);
-    const uint8_t controlRegister = Wire.read();
+    // Read the control register (1 byte).
+    uint8_t controlRegister;
+    prepareTransfer(&gTransfer, cControlRegister, &controlRegister, 1, true);
+    if (!TwiMaster::execute(&gTransfer)) {
+        return false;
+    }
     // If the 7th bit is zero, the RTC is running.
     return (controlRegister&_BV(7))==0;
 }
@@ -133,14 +242,12 @@ bool isRunning()
     
 float getTemperature()
 {
-    // Address the temperature register.
-    Wire.beginTransmission(cChipAddress);
-    Wire.write(cTemperatureRegister);
-    Wire.endTransmission();
-    // Read the temperature.
-    Wire.requestFrom(cChipAddress, 2u);
-    const int8_t temperatureMSB = Wire.read();
-    const uint8_t temperatureLSB = Wire.read();
+    // Read the temperature registers.
+    uint8_t registers[2];
+    prepareTransfer(&gTransfer, cTemperatureRegister, registers, sizeof(registers), true);
+    TwiMaster::execute(&gTransfer);
+    const int8_t temperatureMSB = registers[0];
+    const uint8_t temperatureLSB = registers[1];
     // Create a float from this values.
     float result = static_cast<float>(temperatureMSB);
     const float fraction = static_cast<float>(temperatureLSB >> 6) * 0.25f;
@@ -153,7 +260,92 @@ float getTemperature()
 }
     
 
+
+bool setAlarm(Alarm alarm, const DateTime &dateTime, AlarmMatch match)
+{
+    // The registers of alarm 1 are seconds, minutes, hours and day of the
+    // month, alarm 2 has no seconds. The mask bit is set for each value
+    // which has not to match.
+    uint8_t registers[4];
+    registers[0] = convertBinToBcd(dateTime.getSecond());
+    registers[1] = convertBinToBcd(dateTime.getMinute());
+    registers[2] = convertBinToBcd(dateTime.getHour());
+    registers[3] = convertBinToBcd(dateTime.getDay());
+    for (uint8_t i = match; i < 4; ++i) {
+        registers[i] |= cAlarmMaskBit;
+    }
+    if (alarm == Alarm1) {
+        prepareTransfer(&gTransfer, cAlarm1Register, registers, 4, false);
+    } else {
+        prepareTransfer(&gTransfer, cAlarm2Register, registers+1, 3, false);
+    }
+    if (!TwiMaster::execute(&gTransfer)) {
+        return false;
+    }
+    // Clear a previous alarm and enable the interrupt of the alarm. The
+    // control register is only written back if it was read, so a failed
+    // read does not clear the other bits.
+    clearAlarms();
+    uint8_t control;
+    if (!readRegister(cControlRegister, control)) {
+        return false;
+    }
+    return writeRegister(cControlRegister, control|cInterruptControlBit|alarm);
 }
+
+
+bool disableAlarm(Alarm alarm)
+{
+    uint8_t control;
+    const bool success = readRegister(cControlRegister, control) && writeRegister(cControlRegister, control&~alarm);
+    clearAlarms();
+    return success;
+}
+
+
+void clearAlarms()
+{
+    // The flags can only be written to zero, so writing a one keeps the
+    // oscillator stop flag. The 32kHz output keeps its power-on state.
+    writeRegister(cStatusRegister, cOscillatorStopFlag|cEnable32kHzBit);
+    if (gAlarmInterruptEnabled) {
+        gAlarmPending = false;
+        EIMSK |= _BV(INT0);
+    }
+}
+
+
+void setAlarmInterruptEnabled(bool enabled)
+{
+    if (enabled) {
+        // The INT/SQW output is open drain, use the internal pull-up.
+        pinMode(cInterruptPin, INPUT);
+        digitalWrite(cInterruptPin, HIGH);
+        EICRA &= ~(_BV(ISC01)|_BV(ISC00)); // Low level, which works in all sleep modes.
+        gAlarmPending = false;
+        gAlarmInterruptEnabled = true;
+        EIMSK |= _BV(INT0);
+    } else {
+        EIMSK &= ~_BV(INT0);
+        gAlarmInterruptEnabled = false;
+    }
+}
+
+
+bool isAlarmPending()
+{
+    return gAlarmPending;
+}
+    
+
+}
+}
+
+
+// The alarm interrupt from the INT/SQW output.
+ISR(INT0_vect)
+{
+    lr::DS3231::onAlarmInterrupt();
 }
 
 
@@ -36,13 +36,27 @@ namespace DS3231 {
 ///    additional bit for the next century. If you set the
 ///    year base to 2000, the RTC will hold the correct time
 ///    for 200 years, starting from 2000-01-01 00:00:00.
+/// @param clock The bus clock used for the chip in Hz.
+///    The DS3231 supports up to 400kHz.
 ///
-void begin(uint16_t yearBase = 2000);
+void begin(uint16_t yearBase = 2000, uint32_t clock = 100000);
 
 /// Get the current date/time.
 ///
 DateTime getDateTime();
 
+/// The function called with the time read in the background.
+///
+/// This function is called from the TWI interrupt, it has to be short.
+///
+typedef void (*DateTimeCallback)(const DateTime &dateTime);
+
+/// Read the date/time in the background.
+///
+/// If the transfer fails, the callback gets the first date/time.
+///
+void getDateTimeAsync(DateTimeCallback callback);
+
 /// Set the date/time.
 ///
 void setDateTime(const DateTime &dateTime);
@@ -56,6 +70,71 @@ bool isRunning();
 float getTemperature();
 
 
+/// The two alarms of the chip.
+///
+/// The values are masks, so alarms can be combined.
+///
+enum Alarm : uint8_t {
+    Alarm1 = _BV(0), ///< Alarm 1, with a resolution of seconds.
+    Alarm2 = _BV(1) ///< Alarm 2, with a resolution of minutes.
+};
+
+
+/// Which parts of the time have to match to trigger an alarm.
+///
+/// Alarm 2 has no seconds and always triggers at second zero.
+///
+enum AlarmMatch : uint8_t {
+    MatchNothing, ///< Alarm 1 triggers every second, alarm 2 every minute.
+    MatchSeconds, ///< The seconds match, once a minute (alarm 1 only).
+    MatchMinutes, ///< The minutes and seconds match, once an hour.
+    MatchHours, ///< The hours, minutes and seconds match, once a day.
+    MatchDay ///< The day of the month and the time match, once a month.
+};
+
+
+/// Set an alarm.
+///
+/// This enables the interrupt of the alarm, the INT/SQW output of the
+/// chip goes low when the alarm triggers. It stays low until the alarm
+/// is cleared with clearAlarms().
+///
+/// @param alarm The alarm to set.
+/// @param dateTime The time of the alarm, only the parts selected by `match` are used.
+/// @param match Which parts of the time have to match.
+/// @return true on success, false if the chip could not be accessed.
+///
+bool setAlarm(Alarm alarm, const DateTime &dateTime, AlarmMatch match);
+
+/// Disable the interrupt of an alarm.
+///
+/// @param alarm The alarm to disable.
+/// @return true on success, false if the chip could not be accessed.
+///
+bool disableAlarm(Alarm alarm);
+
+/// Clear all triggered alarms.
+///
+/// This releases the INT/SQW output of the chip and enables the alarm
+/// interrupt again, if it is enabled. The flags are cleared with a
+/// single write, without reading them first.
+///
+void clearAlarms();
+
+/// Enable or disable the alarm interrupt.
+///
+/// The INT/SQW output of the chip has to be connected to digital pin 2,
+/// which is used as external interrupt INT0 with the internal pull-up.
+/// The low level interrupt also wakes the microcontroller from the
+/// power-down sleep mode.
+///
+void setAlarmInterruptEnabled(bool enabled);
+
+/// Check if an alarm interrupt occurred since the last call of clearAlarms().
+///
+bool isAlarmPending();
+
+
 }
 }
 
@@ -19,8 +19,6 @@
 //
 
 
-#include <Wire.h>
-
 #include "Application.h"
 
 
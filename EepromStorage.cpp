@@ -0,0 +1,89 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "EepromStorage.h"
+
+
+#include <avr/eeprom.h>
+
+
+namespace lr {
+namespace EepromStorage {
+
+
+// forward declarations
+bool begin();
+uint32_t size();
+void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size);
+void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size);
+
+
+/// The functions of this backend.
+///
+/// The EEPROM is read and written directly, there is
+/// no need for an own sequential read or a write cache. Each byte
+/// of the EEPROM supports only about 100000 writes.
+///
+static const Storage::Backend cBackend = {
+    &begin,
+    &size,
+    &readBytes,
+    nullptr,
+    nullptr,
+    &writeBytes,
+    nullptr,
+    nullptr,
+    true
+};
+
+
+const Storage::Backend* getBackend()
+{
+    return &cBackend;
+}
+
+
+bool begin()
+{
+    return true;
+}
+
+
+uint32_t size()
+{
+    return E2END + 1;
+}
+
+
+void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size)
+{
+    eeprom_read_block(data, reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndex)), size);
+}
+
+
+void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size)
+{
+    eeprom_update_block(data, reinterpret_cast<void*>(static_cast<uintptr_t>(firstIndex)), size);
+}
+
+
+}
+}
+
+
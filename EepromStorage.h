@@ -0,0 +1,45 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include "Storage.h"
+
+
+namespace lr {
+
+
+/// The storage backend for the internal EEPROM of the AVR.
+///
+/// The EEPROM is small and slow to write, but requires no additional
+/// hardware. Only changed bytes are written to save write cycles.
+///
+namespace EepromStorage {
+
+
+/// Get the backend for the storage.
+///
+const Storage::Backend* getBackend();
+
+
+}
+}
+
+
@@ -0,0 +1,426 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "FramStorage.h"
+
+
+#include <string.h>
+
+
+namespace lr {
+namespace FramStorage {
+
+
+/// The address of the first FRAM chip in the I2C bus.
+///
+/// The address is 1010AAA where AAA is the custom address which can
+/// be set with the pins on the chip.
+///
+static const uint8_t cMb85RcAddress = B1010000;
+
+/// The mask for the addresses of all FRAM chips.
+///
+static const uint8_t cMb85RcAddressMask = B1111000;
+
+/// The address to read the device ID of the FRAM chip.
+///
+static const uint8_t cDeviceIdAddress = 0xf8>>1;
+
+/// The maximum number of chips on the bus.
+///
+static const uint8_t cMaximumChipCount = 8;
+
+/// The size of the memory of one chip.
+///
+static const uint32_t cChipSize = 32768; // 32KB
+
+/// The size of a page.
+///
+/// With more than one chip, consecutive pages are stored on
+/// consecutive chips. Each chip keeps its own address pointer,
+/// so a sequential read over all chips needs no addressing.
+///
+static const uint8_t cPageSize = 32;
+
+/// The number of bytes read in advance for a sequential read.
+///
+static const uint8_t cStreamBufferSize = 32;
+
+/// The size of one write cache.
+///
+static const uint8_t cWriteCacheSize = 32;
+
+/// The number of write caches.
+///
+/// While one cache is written in the background, the next one
+/// can be filled.
+///
+static const uint8_t cWriteCacheCount = 2;
+
+
+/// A write cache with its transfer.
+///
+struct WriteCache {
+    TwiMaster::Transfer transfer; ///< The transfer to write the cache.
+    uint8_t data[cWriteCacheSize]; ///< The cached bytes.
+};
+
+
+/// The location of an index in the chips.
+///
+struct Location {
+    uint8_t chip; ///< The index of the chip.
+    uint16_t address; ///< The address in the chip.
+    uint16_t size; ///< The number of bytes to the end of the page.
+};
+
+
+static TwiMaster::Transfer gTransfer; ///< The transfer for all synchronous reads.
+static uint8_t gChipCount = 0; ///< The number of chips.
+static uint8_t gChipBusAddresses[cMaximumChipCount]; ///< The bus address of each chip.
+static uint16_t gChipAddress[cMaximumChipCount]; ///< The address pointer of each chip.
+static volatile bool gChipAddressValid[cMaximumChipCount]; ///< If the address pointer of the chip is known.
+static uint8_t gStreamBuffer[cStreamBufferSize]; ///< The bytes read in advance for the sequential read.
+static uint8_t gStreamBufferPosition; ///< The position of the next byte in the stream buffer.
+static uint8_t gStreamBufferSize; ///< The number of bytes in the stream buffer.
+static uint32_t gStreamNextIndex; ///< The index of the first byte after the stream buffer.
+static WriteCache gWriteCaches[cWriteCacheCount]; ///< The write caches.
+static uint8_t gWriteCacheSelected; ///< The write cache which is filled.
+static uint32_t gWriteCacheIndex; ///< The index of the first byte in the selected write cache.
+static uint8_t gWriteCacheSize; ///< The number of bytes in the selected write cache.
+static uint8_t gWriteCacheLimit; ///< The maximum number of bytes in the selected write cache.
+
+
+// forward declarations
+bool begin();
+uint32_t size();
+void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size);
+void beginSequentialRead(uint32_t firstIndex);
+void readNextBytes(uint8_t *data, uint32_t size);
+void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size);
+void writeBytesAsync(uint32_t firstIndex, const uint8_t *data, uint32_t size, TwiMaster::Transfer *transfer);
+
+
+/// The functions of this backend.
+///
+static const Storage::Backend cBackend = {
+    &begin,
+    &size,
+    &readBytes,
+    &beginSequentialRead,
+    &readNextBytes,
+    &writeBytes,
+    &writeBytesAsync,
+    &flush,
+    false
+};
+
+
+/// Get the location of an index.
+///
+/// A single chip is handled as one large page, so transfers are
+/// only split at the end of the memory.
+///
+Location getLocation(uint32_t index)
+{
+    Location location;
+    if (gChipCount == 1) {
+        location.chip = 0;
+        location.address = static_cast<uint16_t>(index);
+        location.size = static_cast<uint16_t>(cChipSize - index);
+    } else {
+        const uint32_t page = index / cPageSize;
+        const uint8_t offset = static_cast<uint8_t>(index % cPageSize);
+        location.chip = static_cast<uint8_t>(page % gChipCount);
+        location.address = static_cast<uint16_t>((page / gChipCount) * cPageSize + offset);
+        location.size = cPageSize - offset;
+    }
+    return location;
+}
+
+
+/// Prepare a transfer to a chip.
+///
+/// @param transfer The transfer to prepare.
+/// @param chip The index of the chip.
+/// @param address The address to send as command, or a negative value to
+///   use the current address pointer of the chip.
+///
+void prepareTransfer(TwiMaster::Transfer *transfer, uint8_t chip, int32_t address)
+{
+    memset(transfer, 0, sizeof(TwiMaster::Transfer));
+    transfer->address = gChipBusAddresses[chip];
+    if (address >= 0) {
+        transfer->command[0] = static_cast<uint8_t>(address>>8);
+        transfer->command[1] = static_cast<uint8_t>(address&0xff);
+        transfer->commandSize = 2;
+    }
+}
+
+
+/// Called at the end of a write in the background.
+///
+void onWriteFinished(TwiMaster::Transfer *transfer)
+{
+    if (transfer->status != TwiMaster::Done) {
+        for (uint8_t chip = 0; chip < gChipCount; ++chip) {
+            if (gChipBusAddresses[chip] == transfer->address) {
+                gChipAddressValid[chip] = false;
+            }
+        }
+    }
+}
+
+
+/// Read bytes in one transfer.
+///
+/// The address is only sent if the address pointer of the chip
+/// is not already at the given location.
+///
+/// @param location The location of the first byte.
+/// @param data A pointer to the target buffer.
+/// @param size The number of bytes, up to the end of the page.
+///
+void readAt(const Location &location, uint8_t *data, uint16_t size)
+{
+    flush();
+    const uint8_t chip = location.chip;
+    const bool isAtAddress = (gChipAddressValid[chip] && gChipAddress[chip] == location.address);
+    prepareTransfer(&gTransfer, chip, isAtAddress ? -1 : location.address);
+    gTransfer.readData = data;
+    gTransfer.dataSize = size;
+    gChipAddressValid[chip] = TwiMaster::execute(&gTransfer);
+    gChipAddress[chip] = (location.address + size) & (cChipSize - 1);
+}
+
+
+/// Drop all bytes read in advance for the sequential read.
+///
+/// This is required after each write, because the written bytes
+/// could be in the stream buffer.
+///
+void dropStreamBuffer()
+{
+    gStreamNextIndex -= (gStreamBufferSize - gStreamBufferPosition);
+    gStreamBufferPosition = 0;
+    gStreamBufferSize = 0;
+}
+
+
+/// Check if there is a FRAM chip at the given address.
+///
+/// Reads the manufacturer ID and product ID of the chip.
+///
+bool isChipAvailable(uint8_t busAddress)
+{
+    uint8_t id[3];
+    memset(&gTransfer, 0, sizeof(TwiMaster::Transfer));
+    gTransfer.address = cDeviceIdAddress;
+    gTransfer.command[0] = busAddress<<1;
+    gTransfer.commandSize = 1;
+    gTransfer.readData = id;
+    gTransfer.dataSize = 3;
+    if (!TwiMaster::execute(&gTransfer)) {
+        return false;
+    }
+    const uint16_t manufacturerID = (id[0]<<4)+(id[1]>>4);
+    const uint16_t productID = ((id[1]&0x0f)<<8)+id[2];
+    // Check the both IDs
+    return manufacturerID == 0x00a && productID == 0x510;
+}
+
+
+bool begin()
+{
+    for (uint8_t i = 0; i < cWriteCacheCount; ++i) {
+        gWriteCaches[i].transfer.status = TwiMaster::Done;
+    }
+    gWriteCacheSelected = 0;
+    gWriteCacheSize = 0;
+    gStreamBufferPosition = 0;
+    gStreamBufferSize = 0;
+    gStreamNextIndex = 0;
+    // Find all chips on the bus, they are used in the order of their address.
+    gChipCount = 0;
+    for (uint8_t i = 0; i < cMaximumChipCount; ++i) {
+        if (isChipAvailable(cMb85RcAddress + i)) {
+            gChipBusAddresses[gChipCount] = cMb85RcAddress + i;
+            gChipAddressValid[gChipCount] = false;
+            ++gChipCount;
+        }
+    }
+    return gChipCount > 0;
+}
+
+
+void setBusClock(uint32_t clock)
+{
+    TwiMaster::setDeviceClock(cMb85RcAddress, clock, cMb85RcAddressMask);
+    TwiMaster::setDeviceClock(cDeviceIdAddress, clock);
+}
+
+
+const Storage::Backend* getBackend()
+{
+    return &cBackend;
+}
+
+
+uint8_t getChipCount()
+{
+    return gChipCount;
+}
+
+
+uint32_t size()
+{
+    return cChipSize * gChipCount;
+}
+
+
+void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size)
+{
+    dropStreamBuffer();
+    // Gather adjacent writes in the write cache, it is written
+    // as one burst if it is full or at the next flush.
+    while (size > 0) {
+        if (gWriteCacheSize > 0 &&
+            (gWriteCacheSize == gWriteCacheLimit || firstIndex != (gWriteCacheIndex + gWriteCacheSize))) {
+            flush();
+        }
+        WriteCache &writeCache = gWriteCaches[gWriteCacheSelected];
+        if (gWriteCacheSize == 0) {
+            // Make sure the cache is not written in the background.
+            TwiMaster::waitFor(&writeCache.transfer);
+            gWriteCacheIndex = firstIndex;
+            // A cache is written to one chip, so it ends with the page.
+            const uint16_t pageSize = getLocation(firstIndex).size;
+            gWriteCacheLimit = (pageSize < cWriteCacheSize) ? pageSize : cWriteCacheSize;
+        }
+        uint8_t count = gWriteCacheLimit - gWriteCacheSize;
+        if (count > size) {
+            count = size;
+        }
+        memcpy(writeCache.data + gWriteCacheSize, data, count);
+        gWriteCacheSize += count;
+        firstIndex += count;
+        data += count;
+        size -= count;
+    }
+}
+
+
+void writeBytesAsync(uint32_t firstIndex, const uint8_t *data, uint32_t size, TwiMaster::Transfer *transfer)
+{
+    dropStreamBuffer();
+    flush();
+    // The part in the first page is sent directly from the data, a
+    // remainder in the next pages is written using the write cache.
+    const Location location = getLocation(firstIndex);
+    const uint16_t transferSize = (size > location.size) ? location.size : size;
+    prepareTransfer(transfer, location.chip, location.address);
+    transfer->writeData = data;
+    transfer->dataSize = transferSize;
+    TwiMaster::queue(transfer);
+    gChipAddressValid[location.chip] = false; // The result of the transfer is unknown.
+    if (size > transferSize) {
+        writeBytes(firstIndex + transferSize, data + transferSize, size - transferSize);
+        flush();
+    }
+}
+
+
+void flush()
+{
+    if (gWriteCacheSize == 0) {
+        return;
+    }
+    // Write the selected cache in the background and select the next one.
+    WriteCache &writeCache = gWriteCaches[gWriteCacheSelected];
+    const Location location = getLocation(gWriteCacheIndex);
+    prepareTransfer(&writeCache.transfer, location.chip, location.address);
+    writeCache.transfer.writeData = writeCache.data;
+    writeCache.transfer.dataSize = gWriteCacheSize;
+    writeCache.transfer.callback = &onWriteFinished;
+    gChipAddress[location.chip] = (location.address + gWriteCacheSize) & (cChipSize - 1);
+    gChipAddressValid[location.chip] = true;
+    TwiMaster::queue(&writeCache.transfer);
+    gWriteCacheSelected = (gWriteCacheSelected + 1) % cWriteCacheCount;
+    gWriteCacheSize = 0;
+}
+
+
+void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size)
+{
+    // Read the data in one transfer for each page.
+    while (size > 0) {
+        const Location location = getLocation(firstIndex);
+        const uint16_t transferSize = (size > location.size) ? location.size : size;
+        readAt(location, data, transferSize);
+        firstIndex += transferSize;
+        data += transferSize;
+        size -= transferSize;
+    }
+}
+
+
+void beginSequentialRead(uint32_t firstIndex)
+{
+    const uint32_t bufferStart = gStreamNextIndex - gStreamBufferSize;
+    if (firstIndex >= bufferStart && firstIndex <= gStreamNextIndex) {
+        gStreamBufferPosition = firstIndex - bufferStart; // Keep the buffered bytes.
+    } else {
+        gStreamBufferPosition = 0;
+        gStreamBufferSize = 0;
+        gStreamNextIndex = firstIndex;
+    }
+}
+
+
+void readNextBytes(uint8_t *data, uint32_t size)
+{
+    while (size > 0) {
+        if (gStreamBufferPosition >= gStreamBufferSize) {
+            // Read the next bytes, without sending the address if the
+            // address pointer of the chip is already at the right position.
+            if (gStreamNextIndex >= FramStorage::size()) {
+                gStreamNextIndex = 0; // The address wraps at the end of the memory.
+            }
+            const Location location = getLocation(gStreamNextIndex);
+            uint8_t readSize = cStreamBufferSize;
+            if (readSize > location.size) {
+                readSize = location.size;
+            }
+            readAt(location, gStreamBuffer, readSize);
+            gStreamBufferPosition = 0;
+            gStreamBufferSize = readSize;
+            gStreamNextIndex += readSize;
+        }
+        *data = gStreamBuffer[gStreamBufferPosition];
+        ++gStreamBufferPosition;
+        ++data;
+        --size;
+    }
+}
+
+
+}
+}
+
+
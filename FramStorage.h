@@ -0,0 +1,67 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include "Storage.h"
+#include "TwiMaster.h"
+
+#include <Arduino.h>
+
+
+namespace lr {
+
+
+/// The storage backend for up to eight MB85RC256V FRAM chips.
+///
+/// All chips on the bus are combined into one linear memory, with
+/// consecutive 32 byte pages on consecutive chips. Writes are gathered
+/// in a write cache and written in the background, sequential reads
+/// use the auto increment of the chips.
+///
+namespace FramStorage {
+
+
+/// Set the bus clock used for the chips.
+///
+/// @param clock The clock in Hz. The chips support up to 1MHz.
+///
+void setBusClock(uint32_t clock);
+
+/// Get the backend for the storage.
+///
+const Storage::Backend* getBackend();
+
+/// Get the number of chips found at the start.
+///
+uint8_t getChipCount();
+
+/// Write all bytes from the write cache to the chip.
+///
+/// The bytes are written in the background, use
+/// TwiMaster::waitUntilIdle() to wait until they are written.
+///
+void flush();
+
+
+}
+}
+
+
@@ -20,6 +20,9 @@
 #include "KeyPad.h"
 
 
+#include "config.h"
+
+
 namespace lr {
 namespace KeyPad {
 
@@ -29,7 +32,7 @@ static const uint8_t cKeyUpPin = 6;
 static const uint8_t cKeyDownPin = 8;
 static const uint8_t cKeyLeftPin = 5;
 static const uint8_t cKeyRightPin = 12;
-static const uint8_t cKeyEnterPin = 4;
+static const uint8_t cKeyEnterPin = KEY_ENTER_PIN;
     
 /// All key pins in an array
 static uint8_t gKeyPins[5] = {cKeyUpPin, cKeyDownPin, cKeyLeftPin, cKeyRightPin, cKeyEnterPin};
@@ -73,11 +76,9 @@ Key getPressedKey()
 
 void begin()
 {
-    pinMode(cKeyUpPin, INPUT);
-    pinMode(cKeyDownPin, INPUT);
-    pinMode(cKeyLeftPin, INPUT);
-    pinMode(cKeyRightPin, INPUT);
-    pinMode(cKeyEnterPin, INPUT);
+    for (uint8_t i = 0; i < 5; ++i) {
+        pinMode(gKeyPins[i], INPUT);
+    }
     
     // Set the current keymask, this will ignore initially pressed keys.
     gLastKeyMask = getCurrentKeyMask();
@@ -127,6 +128,41 @@ bool hasNextKey()
     return result;
 }
 
+
+void setKeyPin(Key key, uint8_t pin)
+{
+    for (uint8_t i = 0; i < 5; ++i) {
+        if (gKeyMasks[i] == key) {
+            gKeyPins[i] = pin;
+        }
+    }
+}
+
+
+bool isKeyPin(uint8_t pin)
+{
+    for (uint8_t i = 0; i < 5; ++i) {
+        if (gKeyPins[i] == pin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void setWakeUpEnabled(bool enabled)
+{
+    for (uint8_t i = 0; i < 5; ++i) {
+        const uint8_t pin = gKeyPins[i];
+        if (enabled) {
+            *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+            PCICR |= _BV(digitalPinToPCICRbit(pin));
+        } else {
+            *digitalPinToPCMSK(pin) &= ~_BV(digitalPinToPCMSKbit(pin));
+        }
+    }
+}
+
     
 }
 }
@@ -47,6 +47,17 @@ enum Key : uint8_t {
 ///
 void begin();
 
+/// Change the pin of a key.
+///
+/// Call this before begin(), to use another wiring than the one from
+/// the configuration.
+///
+void setKeyPin(Key key, uint8_t pin);
+
+/// Check if a pin is used by a key.
+///
+bool isKeyPin(uint8_t pin);
+
 /// Check the keypad
 ///
 void checkKeys();
@@ -65,6 +76,18 @@ Key getNextKey();
 ///
 bool hasNextKey();
 
+/// Enable or disable the wake-up by a key press.
+///
+/// This enables the pin change interrupt for all keys, which wakes the
+/// microcontroller from the power-down sleep mode. The keys are still
+/// checked in checkKeys(). The pin change interrupt vectors are defined
+/// by the DHT22 driver, which ignores changes of other pins.
+///
+/// Disable the wake-up after waking up, so the keys do not cause
+/// interrupts while the sensor is read.
+///
+void setWakeUpEnabled(bool enabled);
+
 
 
 }
@@ -0,0 +1,105 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "LogModeView.h"
+
+
+#include "Application.h"
+#include "LogSystem.h"
+#include "Settings.h"
+#include "SharpDisplay.h"
+#include "ViewManager.h"
+
+
+namespace lr {
+namespace LogModeView {
+
+
+// The names of the log modes.
+static const char cMode1[] PROGMEM = "Stop Full";
+static const char cMode2[] PROGMEM = "Overwrite";
+static const char *cModes[2] = {cMode1, cMode2};
+static const uint8_t cModeCount = 2;
+
+// The index from the settings.
+static uint8_t gSettingsIndex;
+
+// The currently selected index.
+static uint8_t gSelectedIndex;
+    
+
+void viewWillAppear()
+{
+    gSettingsIndex = Settings::getLogMode();
+    gSelectedIndex = gSettingsIndex;
+}
+
+
+void updateDisplay()
+{
+    SharpDisplay::setLineText(0, PSTR("Log Mode"));
+    SharpDisplay::fillRow(1, '\x89');
+    for (uint8_t i = 0; i < 7; ++i) {
+        String text;
+        if (i < cModeCount) {
+            if (i == gSettingsIndex) {
+                text = String(F("\x9e "));
+            } else {
+                text = String(F("  "));
+            }
+            text += String(reinterpret_cast<const __FlashStringHelper*>(cModes[i]));
+        }
+        SharpDisplay::setTextInverse(i == gSelectedIndex);
+        SharpDisplay::setLineText(i+2, text);
+    }
+}
+
+
+void handleKey(KeyPad::Key key)
+{
+    switch (key) {
+        case KeyPad::Up:
+            if (gSelectedIndex > 0) {
+                --gSelectedIndex;
+            }
+            break;
+            
+        case KeyPad::Down:
+            if (gSelectedIndex < (cModeCount-1)) {
+                ++gSelectedIndex;
+            }
+            break;
+            
+        case KeyPad::Enter:
+            Settings::setLogMode(static_cast<Settings::LogMode>(gSelectedIndex));
+            LogSystem::setOverwriteOldest(gSelectedIndex == Settings::OverwriteOldest);
+            // fall through
+        case KeyPad::Left:
+            ViewManager::setNextView(ViewManager::MainMenuView);
+            break;
+            
+        default:
+            break;
+    }
+    ViewManager::setNeedsDisplayUpdate();
+}
+
+    
+}
+}
@@ -23,263 +23,2078 @@
 #include "Storage.h"
 
 #include <util/crc16.h>
+#include <math.h>
+#include <string.h>
 
 
 namespace lr {
 
 
 LogRecord::LogRecord()
-    : _dateTime(), _temperature(0.0f), _humidity(0.0f)
+    : _dateTime()
 {    
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        _temperatures[channel] = 0.0f;
+        _humidities[channel] = 0.0f;
+    }
 }
 
 
 LogRecord::~LogRecord()
 {
-}
+}
+
+
+LogRecord::LogRecord(const DateTime &dateTime, float temperature, float humidity)
+    : _dateTime(dateTime)
+{
+    setValues(0, temperature, humidity);
+    for (uint8_t channel = 1; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        _temperatures[channel] = NAN;
+        _humidities[channel] = NAN;
+    }
+}
+
+
+LogRecord::LogRecord(const DateTime &dateTime, const float *temperatures, const float *humidities)
+    : _dateTime(dateTime)
+{
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        setValues(channel, temperatures[channel], humidities[channel]);
+    }
+}
+
+
+void LogRecord::setValues(uint8_t channel, float temperature, float humidity)
+{
+    if (temperature > 100.0f) {
+        temperature = 100.0f;
+    }
+    if (temperature < -273.15f) {
+        temperature = -273.15f;
+    }
+    if (humidity > 100.0f) {
+        humidity = 100.0f;
+    }
+    if (humidity < 0.0f) {
+        humidity = 0.0f;
+    }
+    _temperatures[channel] = temperature;
+    _humidities[channel] = humidity;
+}
+
+
+bool LogRecord::isNull() const
+{
+    if (!_dateTime.isFirst()) {
+        return false;
+    }
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        if (_humidities[channel] != 0.0f || _temperatures[channel] != 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void LogRecord::writeToSerial() const
+{
+    Serial.print(_dateTime.toString(DateTime::FormatLong));
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        Serial.print(",");
+        Serial.print(_temperatures[channel], 2);
+        Serial.print(",");
+        Serial.print(_humidities[channel], 2);
+    }
+    Serial.println();
+}
+
+
+namespace LogSystem {
+
+
+// The log is stored in blocks of a fixed size. Each block starts with a
+// header which contains the first record of the block with absolute values.
+// All following records in the block are stored as compact samples, with
+// the differences to the previous record. Temperature and humidity are
+// stored with a resolution of 1/10, which is the resolution of the sensor.
+// Each record contains the values of all sensor channels, which share the
+// time and the check of the record.
+//
+// Before a block is used, all its samples are set to zero. This way, the
+// first null sample marks the end of the records in a block.
+//
+// When the next block is started, the minimum and maximum values of the
+// first channel are stored as summary at the end of the block. A scan
+// for the extreme values of a range reads these summaries, instead of
+// all samples of the blocks.
+//
+// The blocks are used as a ring. The index of the first record in each
+// block header is a sequence number, which increases with each record
+// since the last format. If the log is full and the oldest records are
+// overwritten, the log continues at the first block and the oldest
+// surviving record moves forward. The sequence numbers are used to find
+// the newest and the oldest block.
+
+
+// The size of a single block on small and on large storage.
+//
+// Large blocks keep more records, because less headers and summaries
+// are stored.
+static const uint16_t cSmallBlockSize = 256;
+static const uint16_t cLargeBlockSize = 512;
+
+// The value stored for a missing temperature or humidity (NAN).
+static const int16_t cNoValue = static_cast<int16_t>(0x8000);
+
+// The difference stored in a sample for a missing value.
+static const int8_t cNoValueDelta = static_cast<int8_t>(0x80);
+
+// The size of the chunks used to zero the storage.
+static const uint8_t cZeroChunkSize = 16;
+
+// The number of rollup tiers.
+static const uint8_t cRollupTierCount = 3;
+
+// The length of the periods of the rollup tiers in seconds: hour, day and week.
+static const uint32_t cRollupPeriodLengths[cRollupTierCount] PROGMEM = {3600, 86400, 604800};
+
+// The offset added to the time to calculate the period, weeks start on monday.
+static const uint32_t cRollupPeriodOffsets[cRollupTierCount] PROGMEM = {0, 0, 5*86400};
+
+// The number of entries of each rollup tier: a day, a month and a year.
+static const uint8_t cRollupCapacities[cRollupTierCount] PROGMEM = {24, 31, 52};
+
+// The minimum size of the storage for large blocks and the rollup tiers.
+static const uint32_t cLargeStorageSize = 16384;
+
+// The period value for an unused rollup.
+static const uint32_t cNoPeriod = 0xffffffff;
+
+// The number of seconds in the range of the last day statistics.
+static const uint32_t cSecondsPerDay = 86400;
+
+
+// The values of one sensor channel.
+//
+struct InternalValues
+{
+    int16_t temperature; // The temperature in 1/10 degrees celsius.
+    int16_t humidity; // The humidity in 1/10 percent.
+};
+
+
+// The differences of the values of one sensor channel.
+//
+struct InternalDeltas
+{
+    int8_t temperatureDelta; // The difference to the previous temperature in 1/10 degrees.
+    int8_t humidityDelta; // The difference to the previous humidity in 1/10 percent.
+};
+
+
+// The header of a block.
+//
+struct InternalBlockHeader
+{
+    uint32_t firstRecord; // The sequence number of the first record in this block.
+    uint32_t time; // The time as seconds since 2000-01-01 00:00:00.
+    uint32_t expectedDelta; // The expected seconds between two records in this block.
+    InternalValues values[SENSOR_CHANNEL_COUNT]; // The values of all channels.
+    uint16_t crc; // The CRC-16 of the header.
+};
+
+
+// A single sample in a block.
+//
+struct InternalSample
+{
+    int8_t timeDelta; // The seconds since the previous record, minus the expected delta.
+    InternalDeltas deltas[SENSOR_CHANNEL_COUNT]; // The differences of all channels.
+    uint8_t check; // The CRC-8 of the sample.
+};
+
+
+// The minimum and maximum of one kind of value in a block.
+//
+// Both values are cNoValue if the block has no such values.
+//
+struct InternalValueRange
+{
+    int16_t minimum; // The minimum value in 1/10 units.
+    int16_t maximum; // The maximum value in 1/10 units.
+};
+
+
+// The summary of the first channel of all records in a block.
+//
+// The summary is stored at the end of the block, when the next block
+// is started.
+//
+struct InternalBlockSummary
+{
+    InternalValueRange temperature; // The range of the temperatures.
+    InternalValueRange humidity; // The range of the humidities.
+    uint16_t crc; // The CRC-16 of the summary.
+};
+
+
+// The persisted head of the log.
+//
+// This structure is stored at the end of the storage. It keeps the
+// position of the oldest block and the number of records and blocks,
+// so the end of the log can be found without scanning all blocks at
+// startup.
+//
+struct InternalLogHead
+{
+    uint32_t nextRecord; // The sequence number of the next record.
+    uint32_t firstRecord; // The sequence number of the oldest record.
+    uint16_t firstBlock; // The index of the oldest block.
+    uint16_t numberOfBlocks; // The number of used blocks.
+    uint16_t crc; // The CRC-16 of the head.
+};
+
+
+// The values of one kind in one period of a rollup tier.
+//
+struct InternalRollupValue
+{
+    int16_t minimum; // The minimum value in 1/10 units.
+    int16_t maximum; // The maximum value in 1/10 units.
+    int16_t mean; // The rounded mean value in 1/10 units.
+    uint16_t count; // The number of records with this value.
+};
+
+
+// The values of all records in one period of a rollup tier.
+//
+// The rollup of a period is stored at the index of the period modulo
+// the capacity of the tier. The cycle is the period divided by the
+// capacity, so the period of an entry is known without storing it.
+//
+struct InternalRollup
+{
+    uint16_t cycle; // The period divided by the capacity of the tier.
+    uint16_t numberOfRecords; // The number of records in the period.
+    InternalRollupValue temperature; // The temperatures in 1/10 degrees.
+    InternalRollupValue humidity; // The humidities in 1/10 percent.
+    uint16_t crc; // The CRC-16 of the rollup.
+};
+
+
+// A position in the log.
+//
+// The cursor contains all values of the record at this position, which
+// are required to decode the following sample in the same block.
+//
+struct Cursor
+{
+    uint16_t blockIndex; // The index of the block.
+    uint32_t firstRecord; // The sequence number of the first record in the block.
+    uint32_t expectedDelta; // The expected seconds between two records in the block.
+    uint8_t checkSeed; // The initial value for the sample checks of the block.
+    uint32_t recordIndex; // The sequence number of the record at this position.
+    uint32_t time; // The time of the record.
+    InternalValues values[SENSOR_CHANNEL_COUNT]; // The values of the record.
+};
+
+
+// The running statistics of the values of one kind.
+//
+// The sums are kept as integers, so the oldest values can be removed
+// again without rounding errors. Values are in 1/10 units.
+//
+struct RunningValue
+{
+    uint64_t sumOfSquares; // The sum of the squares of all values.
+    int32_t sum; // The sum of all values.
+    uint32_t count; // The number of values.
+    int16_t minimum; // The minimum value.
+    int16_t maximum; // The maximum value.
+    uint32_t minimumRecord; // The sequence number of the last record with the minimum value.
+    uint32_t maximumRecord; // The sequence number of the last record with the maximum value.
+};
+
+
+// The values of one kind in the rollup of the current period.
+//
+// The rollup keeps the sum, so the mean of the period does not lose
+// precision while records are added.
+//
+struct RollupValue
+{
+    int16_t minimum; // The minimum value.
+    int16_t maximum; // The maximum value.
+    uint16_t count; // The number of values.
+    int32_t sum; // The sum of all values.
+};
+
+
+// The rollup of the current period of a tier.
+//
+struct Rollup
+{
+    uint32_t period; // The number of the period since 2000-01-01.
+    uint16_t numberOfRecords; // The number of records in the period.
+    RollupValue temperature; // The temperatures in 1/10 degrees.
+    RollupValue humidity; // The humidities in 1/10 percent.
+};
+
+
+// The combined values of one kind of the rollups in a summary.
+//
+struct SummaryValue
+{
+    int16_t minimum; // The minimum value.
+    int16_t maximum; // The maximum value.
+    uint32_t count; // The number of values.
+    float sum; // The sum of all values.
+};
+
+
+// The combined rollups of a summary.
+//
+struct SummaryTotal
+{
+    uint32_t numberOfRecords; // The number of records.
+    SummaryValue temperature; // The temperatures in 1/10 degrees.
+    SummaryValue humidity; // The humidities in 1/10 percent.
+    bool complete; // If all periods of the range were available.
+};
+
+
+// The running statistics of a range of records.
+//
+struct RunningStatistics
+{
+    uint32_t numberOfRecords; // The number of records in the range.
+    RunningValue temperature; // The statistics of the temperatures.
+    RunningValue humidity; // The statistics of the humidities.
+};
+
+
+// The persisted statistics.
+//
+// This structure is stored in front of the rollup tiers and written
+// after each record, so the statistics are not calculated from all
+// records at the start.
+//
+struct InternalStatistics
+{
+    uint32_t firstRecord; // The sequence number of the oldest record.
+    uint32_t nextRecord; // The sequence number of the next record.
+    uint32_t dayRecord; // The sequence number of the first record of the last day.
+    RunningStatistics all; // The statistics of all records.
+    RunningStatistics day; // The statistics of the records of the last day.
+    uint16_t crc; // The CRC-16 of the statistics.
+};
+
+
+static uint32_t gReservedForConfig; ///< The number of bytes reserved for the settings.
+static uint16_t gBlockSize; ///< The size of a block.
+static uint8_t gSamplesPerBlock; ///< The number of samples which fit in one block.
+static uint32_t gFirstRecord; ///< The sequence number of the oldest record.
+static uint32_t gNextRecord; ///< The sequence number of the next record.
+static uint32_t gMaximumNumberOfRecords; ///< The maximum number of records.
+static uint16_t gFirstBlock; ///< The index of the oldest block.
+static uint16_t gCurrentNumberOfBlocks; ///< The current number of used blocks.
+static uint16_t gMaximumNumberOfBlocks; ///< The maximum number of blocks.
+static bool gOverwriteOldest = false; ///< If the oldest block is overwritten if the log is full.
+static uint32_t gRecordInterval = 0; ///< The interval between two records, or 0 if it is not known.
+static bool gHeadPersisted; ///< If the head and the statistics are written to the storage, false for memory with limited endurance.
+static uint32_t gRollupStart; ///< The start of the rollup tiers in the storage.
+static bool gRollupsEnabled; ///< If the storage is large enough for the rollup tiers.
+static Rollup gRollups[cRollupTierCount]; ///< The rollups of the current periods.
+static InternalStatistics gStatistics; ///< The statistics, which are written in the background from here.
+static RunningStatistics &gAllStatistics = gStatistics.all; ///< The statistics of all records.
+static RunningStatistics &gDayStatistics = gStatistics.day; ///< The statistics of the records of the last day.
+static TwiMaster::Transfer gStatisticsTransfer; ///< The transfer to write the statistics.
+static InternalBlockSummary gWriteSummary; ///< The summary of the block at the write cursor.
+static Cursor gDayCursor; ///< The position of the first record of the last day.
+static Cursor gWriteCursor; ///< The position of the last record in the log.
+static Cursor gReadCursor; ///< The position of the last read record.
+static bool gReadCursorValid; ///< If the read cursor can be used.
+static bool gStreamValid; ///< If the sequential read of the storage is at the stream position.
+static uint16_t gStreamBlock; ///< The block of the next sample in the sequential read.
+static uint8_t gStreamSample; ///< The index of the next sample in the sequential read.
+static InternalSample gSampleBuffer; ///< The last appended sample, while it is written in the background.
+static TwiMaster::Transfer gSampleTransfer; ///< The transfer to write the last appended sample.
+static InternalLogHead gHeadBuffer; ///< The last head, while it is written in the background.
+static TwiMaster::Transfer gHeadTransfer; ///< The transfer to write the last head.
+
+
+// Calculate the start of the persisted head.
+//
+inline uint32_t getHeadStart()
+{
+    return Storage::size() - sizeof(InternalLogHead);
+}
+
+
+// Calculate the start of the persisted statistics.
+//
+inline uint32_t getStatisticsStart()
+{
+    return getHeadStart() - sizeof(InternalStatistics);
+}
+
+
+// Calculate the size of all rollup tiers.
+//
+uint16_t getRollupAreaSize()
+{
+    uint16_t size = 0;
+    for (uint8_t tier = 0; tier < cRollupTierCount; ++tier) {
+        size += pgm_read_byte(&cRollupCapacities[tier]) * sizeof(InternalRollup);
+    }
+    return size;
+}
+
+
+// Calculate the start of a rollup.
+//
+// Each tier is a table, where the rollup of a period is stored at the
+// index of the period modulo the capacity of the tier.
+//
+uint32_t getRollupStart(uint8_t tier, uint32_t period)
+{
+    uint32_t start = gRollupStart;
+    for (uint8_t i = 0; i < tier; ++i) {
+        start += pgm_read_byte(&cRollupCapacities[i]) * sizeof(InternalRollup);
+    }
+    return start + (period % pgm_read_byte(&cRollupCapacities[tier])) * sizeof(InternalRollup);
+}
+
+
+// Get the period of a rollup tier for a time.
+//
+inline uint32_t getRollupPeriod(uint8_t tier, uint32_t time)
+{
+    return (time + pgm_read_dword(&cRollupPeriodOffsets[tier])) / pgm_read_dword(&cRollupPeriodLengths[tier]);
+}
+
+
+// Calculate the start of a block.
+//
+inline uint32_t getBlockStart(uint16_t blockIndex)
+{
+    return gReservedForConfig + (static_cast<uint32_t>(gBlockSize) * blockIndex);
+}
+
+
+// Calculate the start of the summary at the end of a block.
+//
+inline uint32_t getBlockSummaryStart(uint16_t blockIndex)
+{
+    return getBlockStart(blockIndex) + gBlockSize - sizeof(InternalBlockSummary);
+}
+
+
+// Get the index of a block from its position in the log.
+//
+// @param position The position, where 0 is the oldest block.
+//
+inline uint16_t getBlockAtPosition(uint16_t position)
+{
+    const uint16_t blockIndex = gFirstBlock + position;
+    return (blockIndex < gMaximumNumberOfBlocks) ? blockIndex : (blockIndex - gMaximumNumberOfBlocks);
+}
+
+
+// Get the index of the block following the given one in the ring.
+//
+inline uint16_t getNextBlock(uint16_t blockIndex)
+{
+    return ((blockIndex + 1) < gMaximumNumberOfBlocks) ? (blockIndex + 1) : 0;
+}
+
+
+// Calculate the start of a sample.
+//
+inline uint32_t getSampleStart(uint16_t blockIndex, uint8_t sampleIndex)
+{
+    return getBlockStart(blockIndex) + sizeof(InternalBlockHeader) + (sizeof(InternalSample) * sampleIndex);
+}
+
+
+// Set a range of the storage to zero.
+//
+// @param startIndex The index of the first byte.
+// @param size The number of bytes to set to zero.
+//
+void zeroStorage(uint32_t startIndex, uint16_t size)
+{
+    const uint8_t zeroChunk[cZeroChunkSize] = {0};
+    while (size > 0) {
+        const uint8_t chunkSize = (size > cZeroChunkSize) ? cZeroChunkSize : size;
+        Storage::writeBytes(startIndex, zeroChunk, chunkSize);
+        startIndex += chunkSize;
+        size -= chunkSize;
+    }
+}
+
+
+// Check if a range of memory is null.
+//
+// This is true if all bytes are null.
+//
+// @param data The data to check.
+// @param size The number of bytes to check.
+// @return true if all bytes are null.
+//
+bool isNull(const void *data, uint8_t size)
+{
+    const uint8_t *dataPtr = reinterpret_cast<const uint8_t*>(data);
+    for (uint8_t i = 0; i < size; ++i) {
+        if (*dataPtr != 0) {
+            return false;
+        }
+        ++dataPtr;
+    }
+    return true;
+}
+
+
+// Calculate the CRC-16 for a range of memory.
+//
+// @param data The data to calculate the CRC for.
+// @param size The number of bytes.
+// @return The CRC-16
+//
+uint16_t getCRC(const void *data, uint8_t size)
+{
+    uint16_t crc = 0xFFFF;
+    const uint8_t *dataPtr = reinterpret_cast<const uint8_t*>(data);
+    for (uint8_t i = 0; i < size; ++i) {
+        crc = _crc16_update(crc, *dataPtr);
+        ++dataPtr;
+    }
+    return crc;
+}
+
+
+// Calculate the CRC for a block header.
+//
+// The CRC is calculated as CRC-16 while the CRC field is set to 0.
+//
+// @param header The header to calculate the CRC for.
+// @return The CRC-16
+//
+uint16_t getCRCForInternalHeader(const InternalBlockHeader *header)
+{
+    InternalBlockHeader headerForCRC = *header;
+    headerForCRC.crc = 0;
+    return getCRC(&headerForCRC, sizeof(InternalBlockHeader));
+}
+
+
+// Calculate the CRC for the head.
+//
+// The CRC is calculated as CRC-16 while the CRC field is set to 0.
+//
+// @param head The head to calculate the CRC for.
+// @return The CRC-16
+//
+uint16_t getCRCForInternalHead(const InternalLogHead *head)
+{
+    InternalLogHead headForCRC = *head;
+    headForCRC.crc = 0;
+    return getCRC(&headForCRC, sizeof(InternalLogHead));
+}
+
+
+// Calculate the CRC for a block summary.
+//
+// The CRC is calculated as CRC-16 while the CRC field is set to 0.
+//
+// @param summary The summary to calculate the CRC for.
+// @return The CRC-16
+//
+uint16_t getCRCForInternalBlockSummary(const InternalBlockSummary *summary)
+{
+    InternalBlockSummary summaryForCRC = *summary;
+    summaryForCRC.crc = 0;
+    return getCRC(&summaryForCRC, sizeof(InternalBlockSummary));
+}
+
+
+// Calculate the CRC for the persisted statistics.
+//
+// The CRC is calculated as CRC-16 while the CRC field is set to 0.
+//
+// @param statistics The statistics to calculate the CRC for.
+// @return The CRC-16
+//
+uint16_t getCRCForInternalStatistics(const InternalStatistics *statistics)
+{
+    InternalStatistics statisticsForCRC = *statistics;
+    statisticsForCRC.crc = 0;
+    return getCRC(&statisticsForCRC, sizeof(InternalStatistics));
+}
+
+
+// Calculate the CRC for a rollup.
+//
+// The CRC is calculated as CRC-16 while the CRC field is set to 0.
+//
+// @param rollup The rollup to calculate the CRC for.
+// @return The CRC-16
+//
+uint16_t getCRCForInternalRollup(const InternalRollup *rollup)
+{
+    InternalRollup rollupForCRC = *rollup;
+    rollupForCRC.crc = 0;
+    return getCRC(&rollupForCRC, sizeof(InternalRollup));
+}
+
+
+// Calculate the check value for a sample.
+//
+// The check is a CRC-8 of the sample values and the position of the
+// sample, initialized with a seed from the block header. This makes
+// sure a sample is only valid in its block and at its position. The
+// check is never zero, so a valid sample is never a null sample.
+//
+// @param cursor The cursor at the record before the sample.
+// @param sample The sample to calculate the check for.
+// @return The CRC-8 check value.
+//
+uint8_t getCheckForSample(const Cursor &cursor, const InternalSample *sample)
+{
+    uint8_t check = cursor.checkSeed;
+    check = _crc8_ccitt_update(check, static_cast<uint8_t>(cursor.recordIndex - cursor.firstRecord));
+    check = _crc8_ccitt_update(check, static_cast<uint8_t>(sample->timeDelta));
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        check = _crc8_ccitt_update(check, static_cast<uint8_t>(sample->deltas[channel].temperatureDelta));
+        check = _crc8_ccitt_update(check, static_cast<uint8_t>(sample->deltas[channel].humidityDelta));
+    }
+    return (check != 0) ? check : 0xff;
+}
+
+
+// Convert a value into 1/10 units.
+//
+inline int16_t convertToTenths(float value)
+{
+    if (isnan(value)) {
+        return cNoValue;
+    }
+    return static_cast<int16_t>(lround(value * 10.0f));
+}
+
+
+// Convert a value from 1/10 units.
+//
+inline float convertFromTenths(int16_t value)
+{
+    if (value == cNoValue) {
+        return NAN;
+    }
+    return static_cast<float>(value) / 10.0f;
+}
+
+
+// Get the difference between two values for a sample.
+//
+// @param previous The previous value.
+// @param value The new value.
+// @param delta The variable to store the difference.
+// @return true on success, false if the difference can not be stored in a sample.
+//
+bool getDelta(int16_t previous, int16_t value, int8_t &delta)
+{
+    if (value == cNoValue) {
+        delta = cNoValueDelta;
+        return true;
+    }
+    if (previous == cNoValue) {
+        return false;
+    }
+    const int16_t difference = value - previous;
+    if (difference < -127 || difference > 127) {
+        return false;
+    }
+    delta = static_cast<int8_t>(difference);
+    return true;
+}
+
+
+// Apply the difference from a sample to a value.
+//
+// @param value The previous value, which is changed to the new value.
+// @param delta The difference from the sample.
+// @return true on success, false if the difference is not valid.
+//
+bool applyDelta(int16_t &value, int8_t delta)
+{
+    if (delta == cNoValueDelta) {
+        value = cNoValue;
+        return true;
+    }
+    if (value == cNoValue) {
+        return false;
+    }
+    value += delta;
+    return true;
+}
+
+
+// Create a cursor at the first record of a block.
+//
+// @param blockIndex The index of the block.
+// @param cursor The cursor to initialize.
+// @return true on success, false if the block header is null or invalid.
+//
+bool getCursorForBlock(uint16_t blockIndex, Cursor &cursor)
+{
+    // Read the header as sequential read, so the samples can follow without a new address.
+    InternalBlockHeader header;
+    Storage::beginSequentialRead(getBlockStart(blockIndex));
+    Storage::readNextBytes(reinterpret_cast<uint8_t*>(&header), sizeof(InternalBlockHeader));
+    gStreamValid = true;
+    gStreamBlock = blockIndex;
+    gStreamSample = 0;
+    if (isNull(&header, sizeof(InternalBlockHeader)) || getCRCForInternalHeader(&header) != header.crc) {
+        return false;
+    }
+    cursor.blockIndex = blockIndex;
+    cursor.firstRecord = header.firstRecord;
+    cursor.expectedDelta = header.expectedDelta;
+    cursor.checkSeed = static_cast<uint8_t>(header.crc ^ (header.crc >> 8));
+    cursor.recordIndex = header.firstRecord;
+    cursor.time = header.time;
+    memcpy(cursor.values, header.values, sizeof(cursor.values));
+    return true;
+}
+
+
+// Read a sample from the storage.
+//
+// The samples are usually decoded in sequence, therefore they are read
+// using a sequential read of the storage, which continues at the last
+// read sample or block header.
+//
+// @param blockIndex The index of the block.
+// @param sampleIndex The index of the sample in the block.
+// @param sample The variable to store the sample.
+//
+void readSample(uint16_t blockIndex, uint8_t sampleIndex, InternalSample &sample)
+{
+    if (!gStreamValid || blockIndex != gStreamBlock || sampleIndex != gStreamSample) {
+        Storage::beginSequentialRead(getSampleStart(blockIndex, sampleIndex));
+    }
+    Storage::readNextBytes(reinterpret_cast<uint8_t*>(&sample), sizeof(InternalSample));
+    gStreamValid = true;
+    gStreamBlock = blockIndex;
+    gStreamSample = sampleIndex + 1;
+}
+
+
+// Move a cursor to the next record in the same block.
+//
+// @param cursor The cursor to move.
+// @return true on success, false if there is no valid sample for the next record.
+//
+bool advanceCursor(Cursor &cursor)
+{
+    const uint32_t sampleIndex = cursor.recordIndex - cursor.firstRecord;
+    if (sampleIndex >= gSamplesPerBlock) {
+        return false;
+    }
+    InternalSample sample;
+    readSample(cursor.blockIndex, sampleIndex, sample);
+    if (isNull(&sample, sizeof(InternalSample)) || getCheckForSample(cursor, &sample) != sample.check) {
+        return false;
+    }
+    InternalValues values[SENSOR_CHANNEL_COUNT];
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        values[channel] = cursor.values[channel];
+        if (!applyDelta(values[channel].temperature, sample.deltas[channel].temperatureDelta) ||
+            !applyDelta(values[channel].humidity, sample.deltas[channel].humidityDelta)) {
+            return false;
+        }
+    }
+    cursor.time += cursor.expectedDelta + static_cast<int32_t>(sample.timeDelta);
+    memcpy(cursor.values, values, sizeof(cursor.values));
+    ++cursor.recordIndex;
+    return true;
+}
+
+
+// Move a cursor forward to the given record in the same block.
+//
+// @param cursor The cursor to move.
+// @param index The index of the record.
+// @return true on success, false if the record is not in the block of the cursor.
+//
+bool advanceCursorTo(Cursor &cursor, uint32_t index)
+{
+    if (index < cursor.recordIndex || (index - cursor.firstRecord) > gSamplesPerBlock) {
+        return false;
+    }
+    while (cursor.recordIndex < index) {
+        if (!advanceCursor(cursor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Move a cursor to the next record in the log.
+//
+// At the end of a block, the cursor continues at the next block, if
+// this block follows without a gap.
+//
+// @param cursor The cursor to move.
+// @return true on success, false at the end of the log.
+//
+bool advanceCursorInLog(Cursor &cursor)
+{
+    if (advanceCursor(cursor)) {
+        return true;
+    }
+    if (cursor.blockIndex == gWriteCursor.blockIndex) {
+        return false;
+    }
+    Cursor nextCursor;
+    if (!getCursorForBlock(getNextBlock(cursor.blockIndex), nextCursor) ||
+        nextCursor.firstRecord != (cursor.recordIndex + 1)) {
+        return false;
+    }
+    cursor = nextCursor;
+    return true;
+}
+
+
+// The value used to search for a block.
+//
+enum SearchKey : uint8_t {
+    SearchByRecord, // Search by the index of the first record.
+    SearchByTime // Search by the time of the first record.
+};
+
+
+// Find the last block which starts at or before the given value.
+//
+// This is a binary search over the headers of all used blocks, from the
+// oldest to the newest one. It requires the sequence numbers and times
+// to increase from block to block.
+//
+// @param key The value of the block header to compare.
+// @param value The sequence number or time to search for.
+// @param cursor The cursor to set to the first record of the block.
+// @return true on success, false if a block header is invalid.
+//
+bool findBlock(SearchKey key, uint32_t value, Cursor &cursor)
+{
+    // The low block always starts at or before the value (or is the first
+    // block), the high block always starts after the value.
+    uint16_t low = 0;
+    uint16_t high = gCurrentNumberOfBlocks;
+    if (key == SearchByRecord && value >= gWriteCursor.firstRecord) {
+        low = gCurrentNumberOfBlocks - 1;
+    }
+    while ((high - low) > 1) {
+        const uint16_t middle = low + ((high - low) / 2);
+        if (!getCursorForBlock(getBlockAtPosition(middle), cursor)) {
+            return false;
+        }
+        const uint32_t blockValue = (key == SearchByRecord) ? cursor.firstRecord : cursor.time;
+        if (blockValue <= value) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return getCursorForBlock(getBlockAtPosition(low), cursor);
+}
+
+
+// Add a value to the range of a block summary.
+//
+void addToValueRange(InternalValueRange &range, int16_t value)
+{
+    if (value == cNoValue) {
+        return;
+    }
+    if (range.minimum == cNoValue || value < range.minimum) {
+        range.minimum = value;
+    }
+    if (range.maximum == cNoValue || value > range.maximum) {
+        range.maximum = value;
+    }
+}
+
+
+// Reset a block summary to a block without values.
+//
+void resetBlockSummary(InternalBlockSummary &summary)
+{
+    summary.temperature.minimum = cNoValue;
+    summary.temperature.maximum = cNoValue;
+    summary.humidity.minimum = cNoValue;
+    summary.humidity.maximum = cNoValue;
+    summary.crc = 0;
+}
+
+
+// Add the first channel of a record to a block summary.
+//
+void addToBlockSummary(InternalBlockSummary &summary, const InternalValues &values)
+{
+    addToValueRange(summary.temperature, values.temperature);
+    addToValueRange(summary.humidity, values.humidity);
+}
+
+
+// Calculate the summary of the records from the cursor to the end of its block.
+//
+// @param cursor The cursor at the first record, which is moved to the
+//    last record of the block.
+// @param summary The variable to store the summary.
+//
+void scanBlockSummary(Cursor &cursor, InternalBlockSummary &summary)
+{
+    resetBlockSummary(summary);
+    do {
+        addToBlockSummary(summary, cursor.values[0]);
+    } while (advanceCursor(cursor));
+}
+
+
+// Get the summary of a block of the log.
+//
+// The summary of the block at the write cursor is kept in memory. If
+// the stored summary of a block is invalid, its records are scanned.
+//
+// @param blockIndex The index of the block.
+// @param summary The variable to store the summary.
+//
+void getBlockSummary(uint16_t blockIndex, InternalBlockSummary &summary)
+{
+    if (blockIndex == gWriteCursor.blockIndex) {
+        summary = gWriteSummary;
+        return;
+    }
+    Storage::readBytes(getBlockSummaryStart(blockIndex), reinterpret_cast<uint8_t*>(&summary), sizeof(InternalBlockSummary));
+    if (isNull(&summary, sizeof(InternalBlockSummary)) || getCRCForInternalBlockSummary(&summary) != summary.crc) {
+        Cursor cursor;
+        if (getCursorForBlock(blockIndex, cursor)) {
+            scanBlockSummary(cursor, summary);
+        } else {
+            resetBlockSummary(summary);
+        }
+    }
+}
+
+
+// Write the summary of the block at the write cursor.
+//
+void writeBlockSummary()
+{
+    gWriteSummary.crc = getCRCForInternalBlockSummary(&gWriteSummary);
+    Storage::writeBytes(getBlockSummaryStart(gWriteCursor.blockIndex), reinterpret_cast<const uint8_t*>(&gWriteSummary), sizeof(InternalBlockSummary));
+}
+
+
+// Write the persisted head with the current position of the log.
+//
+// The head changes with every record, so it is not written to memory
+// with limited endurance. The log is found using a scan in this case.
+//
+void setInternalHead()
+{
+    if (!gHeadPersisted) {
+        return;
+    }
+    // The head is written in the background, wait until the buffer is free.
+    Storage::waitForWrite(&gHeadTransfer);
+    InternalLogHead &head = gHeadBuffer;
+    memset(&head, 0, sizeof(InternalLogHead));
+    head.nextRecord = gNextRecord;
+    head.firstRecord = gFirstRecord;
+    head.firstBlock = gFirstBlock;
+    head.numberOfBlocks = gCurrentNumberOfBlocks;
+    head.crc = getCRCForInternalHead(&head);
+    Storage::writeBytesAsync(getHeadStart(), reinterpret_cast<const uint8_t*>(&head), sizeof(InternalLogHead), &gHeadTransfer);
+}
+
+
+// Read the persisted head.
+//
+// @param head The variable to store the head.
+// @return true if the head is valid, false if it is corrupt or missing.
+//
+bool getInternalHead(InternalLogHead &head)
+{
+    if (!gHeadPersisted) {
+        return false;
+    }
+    Storage::readBytes(getHeadStart(), reinterpret_cast<uint8_t*>(&head), sizeof(InternalLogHead));
+    return getCRCForInternalHead(&head) == head.crc &&
+        head.firstRecord <= head.nextRecord &&
+        (head.nextRecord - head.firstRecord) <= gMaximumNumberOfRecords &&
+        head.firstBlock < gMaximumNumberOfBlocks &&
+        head.numberOfBlocks <= gMaximumNumberOfBlocks;
+}
+
+
+// Scan the storage for the end of the log.
+//
+// The scan follows the block headers in the ring, as long as each block
+// continues the previous one. In the last block, all samples are decoded
+// up to the first null or invalid sample. The write cursor is set to the
+// last record and the summary of the last block is calculated.
+//
+// @param blockIndex The block to start the scan.
+// @return true on success, false if the start block is not valid.
+//
+bool scanForEnd(uint16_t blockIndex)
+{
+    Cursor cursor;
+    if (!getCursorForBlock(blockIndex, cursor)) {
+        return false;
+    }
+    Cursor nextCursor;
+    for (uint16_t i = 1; i < gMaximumNumberOfBlocks; ++i) {
+        if (!getCursorForBlock(getNextBlock(cursor.blockIndex), nextCursor) ||
+            nextCursor.firstRecord <= cursor.firstRecord ||
+            nextCursor.firstRecord > (cursor.firstRecord + gSamplesPerBlock + 1)) {
+            break;
+        }
+        cursor = nextCursor;
+    }
+    scanBlockSummary(cursor, gWriteSummary);
+    gWriteCursor = cursor;
+    gNextRecord = cursor.recordIndex + 1;
+    return true;
+}
+
+
+// Set the number of used blocks, from the oldest block to the write cursor.
+//
+void updateNumberOfBlocks()
+{
+    const uint16_t lastBlock = gWriteCursor.blockIndex;
+    gCurrentNumberOfBlocks = ((lastBlock >= gFirstBlock) ? 0 : gMaximumNumberOfBlocks) + lastBlock - gFirstBlock + 1;
+}
+
+
+// Scan all block headers for the oldest and the newest block.
+//
+// This is used if the persisted head is not valid. Because all block
+// headers are set to zero by a format, each valid header belongs to
+// the log.
+//
+void scanAllBlocks()
+{
+    bool found = false;
+    uint16_t newestBlock = 0;
+    uint32_t newestRecord = 0;
+    Cursor cursor;
+    for (uint16_t blockIndex = 0; blockIndex < gMaximumNumberOfBlocks; ++blockIndex) {
+        if (!getCursorForBlock(blockIndex, cursor)) {
+            continue;
+        }
+        if (!found || cursor.firstRecord > newestRecord) {
+            newestBlock = blockIndex;
+            newestRecord = cursor.firstRecord;
+        }
+        if (!found || cursor.firstRecord < gFirstRecord) {
+            gFirstBlock = blockIndex;
+            gFirstRecord = cursor.firstRecord;
+        }
+        found = true;
+    }
+    if (!found || !scanForEnd(newestBlock)) {
+        gFirstBlock = 0;
+        gFirstRecord = 0;
+        return; // The log is empty.
+    }
+    updateNumberOfBlocks();
+}
+
+
+// Add a value to running statistics.
+//
+// @param runningValue The statistics to update.
+// @param value The value to add.
+// @param record The sequence number of the record with the value.
+//
+void addToRunningValue(RunningValue &runningValue, int16_t value, uint32_t record)
+{
+    if (value == cNoValue) {
+        return;
+    }
+    if (runningValue.count == 0 || value <= runningValue.minimum) {
+        runningValue.minimum = value;
+        runningValue.minimumRecord = record;
+    }
+    if (runningValue.count == 0 || value >= runningValue.maximum) {
+        runningValue.maximum = value;
+        runningValue.maximumRecord = record;
+    }
+    ++runningValue.count;
+    runningValue.sum += value;
+    runningValue.sumOfSquares += static_cast<int32_t>(value) * value;
+}
+
+
+// Remove the value of the oldest record from running statistics.
+//
+// @param runningValue The statistics to update.
+// @param value The value to remove.
+// @param record The sequence number of the record with the value.
+// @return false if the record was the last one with the minimum or
+//    maximum, and the range has to be scanned for the new ones.
+//
+bool removeFromRunningValue(RunningValue &runningValue, int16_t value, uint32_t record)
+{
+    if (value == cNoValue) {
+        return true;
+    }
+    if (--runningValue.count == 0) {
+        memset(&runningValue, 0, sizeof(RunningValue));
+        return true;
+    }
+    runningValue.sum -= value;
+    runningValue.sumOfSquares -= static_cast<int32_t>(value) * value;
+    // All older records are already removed, so there is no other
+    // record with the extreme value if its last record is removed.
+    return record != runningValue.minimumRecord && record != runningValue.maximumRecord;
+}
+
+
+// Add the record at the cursor to running statistics.
+//
+void addToRunningStatistics(RunningStatistics &statistics, const Cursor &cursor)
+{
+    ++statistics.numberOfRecords;
+    addToRunningValue(statistics.temperature, cursor.values[0].temperature, cursor.recordIndex);
+    addToRunningValue(statistics.humidity, cursor.values[0].humidity, cursor.recordIndex);
+}
+
+
+// Remove the oldest record of the range, at the cursor, from running statistics.
+//
+// @return false if the minimum or maximum values have to be scanned.
+//
+bool removeFromRunningStatistics(RunningStatistics &statistics, const Cursor &cursor)
+{
+    --statistics.numberOfRecords;
+    const bool temperatureValid = removeFromRunningValue(statistics.temperature, cursor.values[0].temperature, cursor.recordIndex);
+    const bool humidityValid = removeFromRunningValue(statistics.humidity, cursor.values[0].humidity, cursor.recordIndex);
+    return temperatureValid && humidityValid;
+}
+
+
+// The blocks with the last minimum and maximum values of a range.
+//
+struct ValueRangeBlocks
+{
+    uint16_t minimumBlock; // The block with the last minimum value.
+    uint16_t maximumBlock; // The block with the last maximum value.
+};
 
 
-LogRecord::LogRecord(const DateTime &dateTime, float temperature, float humidity)
-    : _dateTime(dateTime), _temperature(temperature), _humidity(humidity)
+// Add the range of a block to the range of the previous blocks.
+//
+// Equal values move the extremes to the later block, so the blocks
+// contain the last records with the extreme values.
+//
+void addBlockToValueRange(InternalValueRange &total, ValueRangeBlocks &blocks, const InternalValueRange &range, uint16_t blockIndex)
 {
-    if (_temperature > 100.0f) {
-        _temperature = 100.0f;
+    if (range.minimum == cNoValue) {
+        return; // The block has no values.
     }
-    if (_temperature < -273.15f) {
-        _temperature = -273.15f;
+    if (total.minimum == cNoValue || range.minimum <= total.minimum) {
+        total.minimum = range.minimum;
+        blocks.minimumBlock = blockIndex;
     }
-    if (_humidity > 100.0f) {
-        _humidity = 100.0f;
+    if (total.maximum == cNoValue || range.maximum >= total.maximum) {
+        total.maximum = range.maximum;
+        blocks.maximumBlock = blockIndex;
     }
-    if (_humidity < 0.0f) {
-        _humidity = 0.0f;
+}
+
+
+// Find the last record with a value in a block.
+//
+// @param blockIndex The block to scan.
+// @param firstCursor The first record of the range, the scan starts here if it is in the block.
+// @param isHumidity true to compare the humidity, false to compare the temperature.
+// @param value The value to search for.
+// @return The sequence number of the last record with the value.
+//
+uint32_t findLastRecordWithValue(uint16_t blockIndex, const Cursor &firstCursor, bool isHumidity, int16_t value)
+{
+    Cursor cursor = firstCursor;
+    if (blockIndex != firstCursor.blockIndex && !getCursorForBlock(blockIndex, cursor)) {
+        return firstCursor.recordIndex;
     }
+    uint32_t record = cursor.recordIndex;
+    do {
+        if ((isHumidity ? cursor.values[0].humidity : cursor.values[0].temperature) == value) {
+            record = cursor.recordIndex;
+        }
+    } while (advanceCursor(cursor));
+    return record;
 }
 
 
-bool LogRecord::isNull() const
+// Set the extreme values of running statistics from a scanned range.
+//
+void setExtremes(RunningValue &runningValue, const InternalValueRange &range, const ValueRangeBlocks &blocks, const Cursor &firstCursor, bool isHumidity)
 {
-    return _dateTime.isFirst() && _humidity == 0.0f && _temperature == 0.0f;
+    if (runningValue.count == 0 || range.minimum == cNoValue) {
+        return;
+    }
+    runningValue.minimum = range.minimum;
+    runningValue.maximum = range.maximum;
+    runningValue.minimumRecord = findLastRecordWithValue(blocks.minimumBlock, firstCursor, isHumidity, range.minimum);
+    runningValue.maximumRecord = findLastRecordWithValue(blocks.maximumBlock, firstCursor, isHumidity, range.maximum);
 }
 
 
-void LogRecord::writeToSerial() const
+// Scan a range for the minimum and maximum values of running statistics.
+//
+// The records of the first block are scanned from the first record of
+// the range, for all following blocks their summaries are used. Only
+// the blocks with the extreme values are scanned for their last records.
+//
+// @param statistics The statistics to update.
+// @param firstCursor The first record of the range, which ends with the log.
+//
+void scanExtremes(RunningStatistics &statistics, const Cursor &firstCursor)
 {
-    Serial.print(_dateTime.toString(DateTime::FormatLong));
-    Serial.print(",");
-    Serial.print(_temperature, 2);
-    Serial.print(",");
-    Serial.println(_humidity, 2);
+    uint16_t blockIndex = firstCursor.blockIndex;
+    Cursor cursor = firstCursor;
+    InternalBlockSummary total;
+    scanBlockSummary(cursor, total);
+    ValueRangeBlocks temperatureBlocks = {blockIndex, blockIndex};
+    ValueRangeBlocks humidityBlocks = {blockIndex, blockIndex};
+    InternalBlockSummary summary;
+    while (blockIndex != gWriteCursor.blockIndex) {
+        blockIndex = getNextBlock(blockIndex);
+        getBlockSummary(blockIndex, summary);
+        addBlockToValueRange(total.temperature, temperatureBlocks, summary.temperature, blockIndex);
+        addBlockToValueRange(total.humidity, humidityBlocks, summary.humidity, blockIndex);
+    }
+    setExtremes(statistics.temperature, total.temperature, temperatureBlocks, firstCursor, false);
+    setExtremes(statistics.humidity, total.humidity, humidityBlocks, firstCursor, true);
 }
 
 
-namespace LogSystem {
+// Reset the statistics for an empty log.
+//
+void resetStatistics()
+{
+    memset(&gAllStatistics, 0, sizeof(RunningStatistics));
+    memset(&gDayStatistics, 0, sizeof(RunningStatistics));
+}
 
 
-static uint32_t gReservedForConfig; ///< The number of bytes reserved for the settings.
-static uint32_t gCurrentNumberOfRecords; ///< The current number of records.
-static uint32_t gMaximumNumberOfRecords; ///< The maximum number of records.
+// Rebuild the statistics of all records and of the last day.
+//
+// The last day ends with the newest record in the log. Both statistics
+// are calculated in one pass over all records. This is only required
+// if the persisted statistics are not valid.
+//
+void rebuildStatistics()
+{
+    resetStatistics();
+    Cursor cursor;
+    if (currentNumberOfRecords() == 0 || !getCursorForBlock(gFirstBlock, cursor)) {
+        return;
+    }
+    const uint32_t dayStart = (gWriteCursor.time >= cSecondsPerDay) ? (gWriteCursor.time - cSecondsPerDay + 1) : 0;
+    do {
+        addToRunningStatistics(gAllStatistics, cursor);
+        if (cursor.time >= dayStart) {
+            if (gDayStatistics.numberOfRecords == 0) {
+                gDayCursor = cursor;
+            }
+            addToRunningStatistics(gDayStatistics, cursor);
+        }
+    } while (advanceCursorInLog(cursor));
+}
 
 
-// The internal representation of a log record.
+// Write the persisted statistics.
+//
+// The statistics are written in the background, they must not be
+// changed until the transfer is finished.
 //
-struct InternalLogRecord
+void setInternalStatistics()
 {
-    uint32_t time; // The time as seconds since 2000-01-01 00:00:00.
-    float humidity; // The humidity value from the sensor.
-    float temperature; // The humidity value from the sensor.
-    uint16_t crc; // The CRC-16 of the record.
-};
+    if (!gHeadPersisted) {
+        return;
+    }
+    gStatistics.firstRecord = gFirstRecord;
+    gStatistics.nextRecord = gNextRecord;
+    gStatistics.dayRecord = gDayCursor.recordIndex;
+    gStatistics.crc = getCRCForInternalStatistics(&gStatistics);
+    Storage::writeBytesAsync(getStatisticsStart(), reinterpret_cast<const uint8_t*>(&gStatistics), sizeof(InternalStatistics), &gStatisticsTransfer);
+}
 
-    
-// Calculate the start of a record.
+
+// Read the persisted statistics.
 //
-inline uint32_t getRecordStart(uint32_t index)
+// @return true on success, false if the statistics are corrupt or do
+//    not match the log.
+//
+bool getInternalStatistics()
 {
-    return gReservedForConfig + (sizeof(InternalLogRecord) * index);
+    if (!gHeadPersisted) {
+        return false;
+    }
+    Storage::readBytes(getStatisticsStart(), reinterpret_cast<uint8_t*>(&gStatistics), sizeof(InternalStatistics));
+    if (getCRCForInternalStatistics(&gStatistics) != gStatistics.crc ||
+        gStatistics.firstRecord != gFirstRecord ||
+        gStatistics.nextRecord != gNextRecord) {
+        return false;
+    }
+    if (gDayStatistics.numberOfRecords > 0 &&
+        (!findBlock(SearchByRecord, gStatistics.dayRecord, gDayCursor) ||
+        !advanceCursorTo(gDayCursor, gStatistics.dayRecord))) {
+        return false;
+    }
+    return true;
 }
 
-    
-// Read one single internal record from the storage.
+
+// Add the last record of the log to the statistics.
 //
-// @param index The index of the record.
-// @return A copy of the internal record.
+// The records which are no longer in the last day are removed. If
+// a removed record had the last minimum or maximum value, the
+// remaining range is scanned for the new values.
 //
-inline InternalLogRecord getInternalRecord(uint32_t index)
+void updateStatistics()
 {
-    InternalLogRecord record;
-    Storage::readBytes(getRecordStart(index), reinterpret_cast<uint8_t*>(&record), sizeof(InternalLogRecord));
-    return record;
+    if (gDayStatistics.numberOfRecords == 0) {
+        gDayCursor = gWriteCursor;
+    }
+    addToRunningStatistics(gAllStatistics, gWriteCursor);
+    addToRunningStatistics(gDayStatistics, gWriteCursor);
+    bool extremesValid = true;
+    while (gDayCursor.recordIndex < gWriteCursor.recordIndex &&
+        (gDayCursor.time + cSecondsPerDay) <= gWriteCursor.time) {
+        if (!removeFromRunningStatistics(gDayStatistics, gDayCursor)) {
+            extremesValid = false;
+        }
+        if (!advanceCursorInLog(gDayCursor)) {
+            rebuildStatistics();
+            return;
+        }
+    }
+    if (!extremesValid) {
+        scanExtremes(gDayStatistics, gDayCursor);
+    }
 }
 
 
-// Write a single internal record to the storage.
+// Remove the records of a block from the statistics.
 //
-// @param record The record to store.
-// @param index The index of the record.
+// If the first record of the last day is in the block, it moves to
+// the first record of the next block.
 //
-inline void setInternalRecord(const InternalLogRecord *record, uint32_t index)
+// @param blockIndex The index of the block.
+// @param nextCursor The cursor at the first record of the next block.
+//
+void removeBlockFromStatistics(uint16_t blockIndex, const Cursor &nextCursor)
 {
-    Storage::writeBytes(getRecordStart(index), reinterpret_cast<const uint8_t*>(record), sizeof(InternalLogRecord));
+    Cursor cursor;
+    if (!getCursorForBlock(blockIndex, cursor)) {
+        return;
+    }
+    bool allExtremesValid = true;
+    bool dayExtremesValid = true;
+    do {
+        if (!removeFromRunningStatistics(gAllStatistics, cursor)) {
+            allExtremesValid = false;
+        }
+        if (gDayCursor.blockIndex == blockIndex && cursor.recordIndex >= gDayCursor.recordIndex &&
+            !removeFromRunningStatistics(gDayStatistics, cursor)) {
+            dayExtremesValid = false;
+        }
+    } while (advanceCursor(cursor));
+    if (gDayCursor.blockIndex == blockIndex) {
+        gDayCursor = nextCursor;
+    }
+    if (!allExtremesValid) {
+        scanExtremes(gAllStatistics, nextCursor);
+    }
+    if (!dayExtremesValid) {
+        scanExtremes(gDayStatistics, gDayCursor);
+    }
 }
-    
 
-// Set a record in the storage to zero.
+
+// Drop the oldest block of the log.
 //
-// @param index The index of the record to zero.
+// The persisted head is updated first, so the records of the block
+// are dropped, before the block is overwritten.
 //
-void zeroInternalRecord(uint32_t index)
+void dropOldestBlock()
 {
-    uint32_t storageIndex = getRecordStart(index);
-    for (uint8_t i = 0; i < sizeof(InternalLogRecord); ++i) {
-        Storage::writeByte(storageIndex, 0);
-        ++storageIndex;
+    const uint16_t droppedBlock = gFirstBlock;
+    gFirstBlock = getNextBlock(gFirstBlock);
+    --gCurrentNumberOfBlocks;
+    Cursor cursor;
+    if (gCurrentNumberOfBlocks > 0 && getCursorForBlock(gFirstBlock, cursor)) {
+        gFirstRecord = cursor.firstRecord;
+        removeBlockFromStatistics(droppedBlock, cursor);
+    } else {
+        gFirstRecord = gNextRecord;
+        resetStatistics();
     }
+    gReadCursorValid = false;
+    setInternalHead();
 }
-    
 
-// Check if an internal record is null.
+
+// Start a new block with the given record.
+//
+// @param time The time of the record.
+// @param values The values of all channels of the record.
 //
-// This is true if all bytes of the records are null.
+void startBlock(uint32_t time, const InternalValues *values)
+{
+    if (gCurrentNumberOfBlocks > 0) {
+        writeBlockSummary();
+    }
+    if (gCurrentNumberOfBlocks >= gMaximumNumberOfBlocks) {
+        // Overwrite the oldest block, invalidate its header first.
+        dropOldestBlock();
+        zeroStorage(getBlockStart(getBlockAtPosition(gCurrentNumberOfBlocks)), sizeof(InternalBlockHeader));
+    }
+    const uint16_t blockIndex = getBlockAtPosition(gCurrentNumberOfBlocks);
+    // Zero all samples and the summary of the new block.
+    zeroStorage(getSampleStart(blockIndex, 0), gBlockSize - sizeof(InternalBlockHeader));
+    // Write the header with the first record.
+    InternalBlockHeader header;
+    memset(&header, 0, sizeof(InternalBlockHeader));
+    header.firstRecord = gNextRecord;
+    header.time = time;
+    if (gRecordInterval != 0) {
+        header.expectedDelta = gRecordInterval;
+    } else if (gNextRecord > gFirstRecord) {
+        header.expectedDelta = time - gWriteCursor.time;
+    }
+    memcpy(header.values, values, sizeof(header.values));
+    header.crc = getCRCForInternalHeader(&header);
+    Storage::writeBytes(getBlockStart(blockIndex), reinterpret_cast<const uint8_t*>(&header), sizeof(InternalBlockHeader));
+    // Move the write cursor to the new block.
+    gWriteCursor.blockIndex = blockIndex;
+    gWriteCursor.firstRecord = header.firstRecord;
+    gWriteCursor.expectedDelta = header.expectedDelta;
+    gWriteCursor.checkSeed = static_cast<uint8_t>(header.crc ^ (header.crc >> 8));
+    gWriteCursor.recordIndex = header.firstRecord;
+    gWriteCursor.time = time;
+    memcpy(gWriteCursor.values, values, sizeof(gWriteCursor.values));
+    resetBlockSummary(gWriteSummary);
+    ++gCurrentNumberOfBlocks;
+}
+
+
+// Append a record as sample to the current block.
 //
-// @param record The record to check.
-// @return true if the record is null.
+// @param time The time of the record.
+// @param values The values of all channels of the record.
+// @return true on success, false if the record does not fit into the current block.
 //
-bool isInternalRecordNull(InternalLogRecord *record)
+bool appendSample(uint32_t time, const InternalValues *values)
 {
-    uint8_t *recordPtr = reinterpret_cast<uint8_t*>(record);
-    for (uint8_t i = 0; i < sizeof(InternalLogRecord); ++i) {
-        if (*recordPtr != 0) {
+    const uint32_t sampleIndex = gWriteCursor.recordIndex - gWriteCursor.firstRecord;
+    if (sampleIndex >= gSamplesPerBlock) {
+        return false;
+    }
+    const int32_t timeDelta = static_cast<int32_t>(time - gWriteCursor.time - gWriteCursor.expectedDelta);
+    if (timeDelta < -128 || timeDelta > 127) {
+        return false;
+    }
+    InternalSample sample;
+    sample.timeDelta = static_cast<int8_t>(timeDelta);
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        if (!getDelta(gWriteCursor.values[channel].temperature, values[channel].temperature, sample.deltas[channel].temperatureDelta) ||
+            !getDelta(gWriteCursor.values[channel].humidity, values[channel].humidity, sample.deltas[channel].humidityDelta)) {
             return false;
         }
-        ++recordPtr;
     }
+    sample.check = getCheckForSample(gWriteCursor, &sample);
+    // The sample is written in the background from its own buffer.
+    Storage::waitForWrite(&gSampleTransfer);
+    gSampleBuffer = sample;
+    Storage::writeBytesAsync(getSampleStart(gWriteCursor.blockIndex, sampleIndex), reinterpret_cast<const uint8_t*>(&gSampleBuffer), sizeof(InternalSample), &gSampleTransfer);
+    gWriteCursor.time = time;
+    memcpy(gWriteCursor.values, values, sizeof(gWriteCursor.values));
+    ++gWriteCursor.recordIndex;
     return true;
 }
 
-    
-// Calculate the CRC for the record.
+
+// Get the cycle of a period in a rollup tier.
 //
-// The CRC is calculated as CRC-16 while the CRC field is set to 0.
-// All nibbles of the CRC-16 combined by XOR.
+inline uint16_t getRollupCycle(uint8_t tier, uint32_t period)
+{
+    return static_cast<uint16_t>(period / pgm_read_byte(&cRollupCapacities[tier]));
+}
+
+
+// Check if a stored rollup is valid and belongs to a period.
 //
-// @param record The record to calculate the CRC for.
-// @return The 4-bit CRC
+bool isRollupForPeriod(uint8_t tier, uint32_t period, const InternalRollup &rollup)
+{
+    return rollup.cycle == getRollupCycle(tier, period) && getCRCForInternalRollup(&rollup) == rollup.crc;
+}
+
+
+// Convert the values of a stored rollup for the current period.
 //
-uint16_t getCRCForInternalRecord(InternalLogRecord *record)
+void getRollupValue(const InternalRollupValue &internalValue, RollupValue &value)
 {
-    uint16_t crc = 0xFFFF;
-    InternalLogRecord recordForCRC = *record;
-    recordForCRC.crc = 0;
-    uint8_t *recordPtr = reinterpret_cast<uint8_t*>(&recordForCRC);
-    for (uint8_t i = 0; i < sizeof(InternalLogRecord); ++i) {
-        crc = _crc16_update(crc, *recordPtr);
-        ++recordPtr;
+    value.minimum = internalValue.minimum;
+    value.maximum = internalValue.maximum;
+    value.count = internalValue.count;
+    value.sum = static_cast<int32_t>(internalValue.mean) * internalValue.count;
+}
+
+
+// Convert the values of the current period for storage.
+//
+void setRollupValue(InternalRollupValue &internalValue, const RollupValue &value)
+{
+    internalValue.minimum = value.minimum;
+    internalValue.maximum = value.maximum;
+    internalValue.count = value.count;
+    if (value.count == 0) {
+        internalValue.mean = 0;
+    } else {
+        const int32_t halfCount = value.count / 2;
+        internalValue.mean = static_cast<int16_t>(((value.sum < 0) ? (value.sum - halfCount) : (value.sum + halfCount)) / value.count);
     }
-    return crc;
 }
-    
-    
-// Check if an internal record is valid.
+
+
+// Read the rollup for a period.
+//
+// @param tier The rollup tier.
+// @param period The period of the tier.
+// @param rollup The variable to store the rollup.
+// @return true on success, false if there is no rollup for the period.
 //
-// This is true if all values of the record are in a valid range
-// and the CRC code is valid.
+bool readRollup(uint8_t tier, uint32_t period, Rollup &rollup)
+{
+    InternalRollup internalRollup;
+    Storage::readBytes(getRollupStart(tier, period), reinterpret_cast<uint8_t*>(&internalRollup), sizeof(InternalRollup));
+    if (!isRollupForPeriod(tier, period, internalRollup)) {
+        return false;
+    }
+    rollup.period = period;
+    rollup.numberOfRecords = internalRollup.numberOfRecords;
+    getRollupValue(internalRollup.temperature, rollup.temperature);
+    getRollupValue(internalRollup.humidity, rollup.humidity);
+    return true;
+}
+
+
+// Write the rollup of the current period of a tier.
 //
-// @param record The record to check.
-// @return true if the record is valid.
+void writeRollup(uint8_t tier, const Rollup &rollup)
+{
+    InternalRollup internalRollup;
+    internalRollup.cycle = getRollupCycle(tier, rollup.period);
+    internalRollup.numberOfRecords = rollup.numberOfRecords;
+    setRollupValue(internalRollup.temperature, rollup.temperature);
+    setRollupValue(internalRollup.humidity, rollup.humidity);
+    internalRollup.crc = getCRCForInternalRollup(&internalRollup);
+    Storage::writeBytes(getRollupStart(tier, rollup.period), reinterpret_cast<const uint8_t*>(&internalRollup), sizeof(InternalRollup));
+}
+
+
+// Add a value to the minimum, maximum and sum of a rollup.
 //
-bool isInternalRecordValid(InternalLogRecord *record)
+void addValueToRollup(int16_t value, RollupValue &rollupValue)
 {
-    if (record->humidity < 0.0f ||
-        record->humidity > 100.0f ||
-        record->temperature < -273.15f ||
-        record->temperature > 100.0f) {
-        return false; // out of range.
+    if (value == cNoValue) {
+        return;
+    }
+    if (rollupValue.count == 0 || value < rollupValue.minimum) {
+        rollupValue.minimum = value;
     }
-    const uint16_t crc = getCRCForInternalRecord(record);
-    return crc == record->crc;
+    if (rollupValue.count == 0 || value > rollupValue.maximum) {
+        rollupValue.maximum = value;
+    }
+    ++rollupValue.count;
+    rollupValue.sum += value;
 }
-    
-    
+
+
+// Add a record to the rollups of its periods.
+//
+// The rollups of the current periods are kept in memory. Each rollup
+// is written after each record, so the tiers are always complete.
+//
+// @param time The time of the record.
+// @param temperature The temperature of the record in 1/10 degrees.
+// @param humidity The humidity of the record in 1/10 percent.
+//
+void updateRollups(uint32_t time, int16_t temperature, int16_t humidity)
+{
+    for (uint8_t tier = 0; tier < cRollupTierCount; ++tier) {
+        Rollup &rollup = gRollups[tier];
+        const uint32_t period = getRollupPeriod(tier, time);
+        if (rollup.period != period) {
+            if (rollup.period != cNoPeriod && period < rollup.period) {
+                continue; // Keep the newer period, if the time was set back.
+            }
+            if (!readRollup(tier, period, rollup)) {
+                memset(&rollup, 0, sizeof(Rollup));
+                rollup.period = period;
+            }
+        }
+        ++rollup.numberOfRecords;
+        addValueToRollup(temperature, rollup.temperature);
+        addValueToRollup(humidity, rollup.humidity);
+        writeRollup(tier, rollup);
+    }
+}
+
+
+// Forget the rollups of the current periods.
+//
+void resetRollups()
+{
+    for (uint8_t tier = 0; tier < cRollupTierCount; ++tier) {
+        gRollups[tier].period = cNoPeriod;
+    }
+}
+
+
+// Find the oldest and the newest record of the log.
+//
+// Start at the last block of the persisted head. The head is written after
+// each record, therefore it is at most one record behind the actual end.
+// To make sure the head belongs to this log, the last block has to contain
+// the record before the head.
+//
+void findLog()
+{
+    InternalLogHead head;
+    if (getInternalHead(head)) {
+        gFirstBlock = head.firstBlock;
+        gFirstRecord = head.firstRecord;
+        gNextRecord = head.nextRecord;
+        Cursor cursor;
+        if (head.numberOfBlocks == 0) {
+            // The log is empty, except a block was started after the head was written.
+            if (getCursorForBlock(gFirstBlock, cursor) && cursor.firstRecord == head.nextRecord) {
+                scanForEnd(gFirstBlock);
+                updateNumberOfBlocks();
+            }
+            return;
+        }
+        const uint16_t lastBlock = getBlockAtPosition(head.numberOfBlocks - 1);
+        if (getCursorForBlock(lastBlock, cursor) &&
+            cursor.firstRecord < head.nextRecord &&
+            head.nextRecord <= (cursor.firstRecord + gSamplesPerBlock + 1) &&
+            scanForEnd(lastBlock) && gNextRecord >= head.nextRecord) {
+            updateNumberOfBlocks();
+            return;
+        }
+    }
+    // The head does not match the records, fall back to a scan of all blocks.
+    gFirstBlock = 0;
+    gFirstRecord = 0;
+    gNextRecord = 0;
+    scanAllBlocks();
+}
+
+
 void begin(uint32_t reservedForConfig)
 {
     gReservedForConfig = reservedForConfig;
-    gCurrentNumberOfRecords = 0;
-    gMaximumNumberOfRecords = 0;
+    gFirstRecord = 0;
+    gNextRecord = 0;
+    gFirstBlock = 0;
+    gCurrentNumberOfBlocks = 0;
+    gReadCursorValid = false;
+    gStreamValid = false;
+    // Writes in the background may be left from a previous start.
+    TwiMaster::waitUntilIdle();
+    gSampleTransfer.status = TwiMaster::Done;
+    gHeadTransfer.status = TwiMaster::Done;
+    gStatisticsTransfer.status = TwiMaster::Done;
+    gHeadPersisted = !Storage::hasLimitedEndurance();
     
-    // Calculate the maximum number of records.
-    gMaximumNumberOfRecords = (Storage::size() - gReservedForConfig) / sizeof(InternalLogRecord);
-    // Scan the storage for valid records.
-    uint32_t index = 0;
-    InternalLogRecord record = getInternalRecord(index);
-    while (!isInternalRecordNull(&record)) {
-        if (!isInternalRecordValid(&record)) {
-            break;
-        }
-        ++index;
-        record = getInternalRecord(index);
+    // Calculate the maximum number of blocks and records. The rollup tiers
+    // are stored in front of the statistics and the head, if the storage
+    // is large enough.
+    const bool isLargeStorage = (Storage::size() >= cLargeStorageSize);
+    gBlockSize = isLargeStorage ? cLargeBlockSize : cSmallBlockSize;
+    gSamplesPerBlock = (gBlockSize - sizeof(InternalBlockHeader) - sizeof(InternalBlockSummary)) / sizeof(InternalSample);
+    gRollupsEnabled = isLargeStorage;
+    gRollupStart = getStatisticsStart() - (gRollupsEnabled ? getRollupAreaSize() : 0);
+    resetRollups();
+    gMaximumNumberOfBlocks = (gRollupStart - gReservedForConfig) / gBlockSize;
+    gMaximumNumberOfRecords = static_cast<uint32_t>(gMaximumNumberOfBlocks) * (gSamplesPerBlock + 1);
+    findLog();
+    // The statistics are updated with each record and persisted. They are
+    // only calculated from all records, if the persisted ones are not valid.
+    if (!getInternalStatistics()) {
+        rebuildStatistics();
+        setInternalStatistics();
     }
-    gCurrentNumberOfRecords = index;
 }
 
 
 LogRecord getLogRecord(uint32_t index)
 {
-    if (index >= gCurrentNumberOfRecords) {
+    if (index >= currentNumberOfRecords()) {
         return LogRecord();
     }
-    const InternalLogRecord record = getInternalRecord(index);
-    return LogRecord(DateTime::fromSecondsSince2000(record.time), record.temperature, record.humidity);
+    // Continue from the last read record or at the start of the next
+    // block if possible, this makes reading the records in sequence fast.
+    const uint32_t record = gFirstRecord + index;
+    Cursor cursor;
+    bool cursorValid = false;
+    if (gReadCursorValid && record >= gReadCursor.recordIndex) {
+        cursor = gReadCursor;
+        cursorValid = advanceCursorTo(cursor, record);
+        if (!cursorValid && gReadCursor.blockIndex != gWriteCursor.blockIndex) {
+            cursorValid = getCursorForBlock(getNextBlock(gReadCursor.blockIndex), cursor) && advanceCursorTo(cursor, record);
+        }
+    }
+    if (!cursorValid) {
+        if (!findBlock(SearchByRecord, record, cursor) || !advanceCursorTo(cursor, record)) {
+            return LogRecord();
+        }
+    }
+    gReadCursor = cursor;
+    gReadCursorValid = true;
+    float temperatures[SENSOR_CHANNEL_COUNT];
+    float humidities[SENSOR_CHANNEL_COUNT];
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        temperatures[channel] = convertFromTenths(cursor.values[channel].temperature);
+        humidities[channel] = convertFromTenths(cursor.values[channel].humidity);
+    }
+    return LogRecord(DateTime::fromSecondsSince2000(cursor.time), temperatures, humidities);
 }
 
 
-bool appendRecord(const LogRecord &logRecord)
+uint32_t findFirstRecordAtOrAfter(const DateTime &dateTime)
+{
+    if (gCurrentNumberOfBlocks == 0) {
+        return 0;
+    }
+    const uint32_t time = dateTime.toSecondsSince2000();
+    Cursor cursor;
+    if (!findBlock(SearchByTime, time, cursor)) {
+        return currentNumberOfRecords();
+    }
+    while (cursor.time < time) {
+        if (!advanceCursor(cursor)) {
+            // All records in this block are before the time.
+            return cursor.recordIndex + 1 - gFirstRecord;
+        }
+    }
+    // Keep the position, so reading the following records is fast.
+    gReadCursor = cursor;
+    gReadCursorValid = true;
+    return cursor.recordIndex - gFirstRecord;
+}
+
+
+RangeIterator::RangeIterator()
+    : _index(0), _end()
+{
+}
+
+
+RangeIterator::RangeIterator(const DateTime &start, const DateTime &end)
+    : _index(findFirstRecordAtOrAfter(start)), _end(end)
+{
+}
+
+
+RangeIterator::~RangeIterator()
+{
+}
+
+
+bool RangeIterator::next(LogRecord &logRecord)
 {
-    if (gCurrentNumberOfRecords >= gMaximumNumberOfRecords) {
+    if (_index >= currentNumberOfRecords() || _end.isFirst()) {
+        return false;
+    }
+    const LogRecord nextRecord = getLogRecord(_index);
+    if (!(nextRecord.getDateTime() < _end)) {
+        _index = currentNumberOfRecords();
         return false;
     }
-    // zero the following record if possible
-    if (gCurrentNumberOfRecords+1 < gMaximumNumberOfRecords) {
-        zeroInternalRecord(gCurrentNumberOfRecords+1);
-    }
-    // convert the record into the internal structure.
-    InternalLogRecord internalRecord;
-    memset(&internalRecord, 0, sizeof(InternalLogRecord));
-    internalRecord.time = logRecord.getDateTime().toSecondsSince2000();
-    internalRecord.humidity = logRecord.getHumidity();
-    internalRecord.temperature = logRecord.getTemperature();
-    internalRecord.crc = getCRCForInternalRecord(&internalRecord);
-    setInternalRecord(&internalRecord, gCurrentNumberOfRecords);
-    gCurrentNumberOfRecords++;
+    logRecord = nextRecord;
+    ++_index;
+    return true;
+}
+
+
+bool appendRecord(const LogRecord &logRecord)
+{
+    // The statistics are written in the background, wait before they are changed.
+    Storage::waitForWrite(&gStatisticsTransfer);
+    const uint32_t time = logRecord.getDateTime().toSecondsSince2000();
+    InternalValues values[SENSOR_CHANNEL_COUNT];
+    for (uint8_t channel = 0; channel < SENSOR_CHANNEL_COUNT; ++channel) {
+        values[channel].temperature = convertToTenths(logRecord.getTemperature(channel));
+        values[channel].humidity = convertToTenths(logRecord.getHumidity(channel));
+    }
+    if (gCurrentNumberOfBlocks == 0 || !appendSample(time, values)) {
+        if (gCurrentNumberOfBlocks >= gMaximumNumberOfBlocks && !gOverwriteOldest) {
+            return false;
+        }
+        startBlock(time, values);
+    }
+    addToBlockSummary(gWriteSummary, values[0]);
+    gNextRecord++;
+    setInternalHead();
+    updateStatistics();
+    setInternalStatistics();
+    if (gRollupsEnabled) {
+        // The rollups are kept for the first channel.
+        updateRollups(time, values[0].temperature, values[0].humidity);
+    }
+    Storage::flush();
     return true;
 }
 
 
 void format()
 {
-    zeroInternalRecord(0);
-    zeroInternalRecord(1);
-    gCurrentNumberOfRecords = 0;
+    // Reset the head first, if the following writes fail, the
+    // scan of all blocks will find the remaining records.
+    gFirstRecord = 0;
+    gNextRecord = 0;
+    gFirstBlock = 0;
+    gCurrentNumberOfBlocks = 0;
+    gReadCursorValid = false;
+    Storage::waitForWrite(&gStatisticsTransfer);
+    resetStatistics();
+    setInternalHead();
+    setInternalStatistics();
+    for (uint16_t blockIndex = 0; blockIndex < gMaximumNumberOfBlocks; ++blockIndex) {
+        zeroStorage(getBlockStart(blockIndex), sizeof(InternalBlockHeader));
+    }
+    if (gRollupsEnabled) {
+        resetRollups();
+        zeroStorage(gRollupStart, getRollupAreaSize());
+    }
+    Storage::flush();
 }
 
-    
-uint32_t maximumNumberOfRecords()
+
+// Convert running statistics of a value into the public structure.
+//
+ValueStatistics getValueStatistics(const RunningValue &runningValue)
 {
-    return gMaximumNumberOfRecords;
+    ValueStatistics valueStatistics;
+    valueStatistics.count = runningValue.count;
+    if (runningValue.count == 0) {
+        valueStatistics.minimum = NAN;
+        valueStatistics.maximum = NAN;
+        valueStatistics.mean = NAN;
+        valueStatistics.standardDeviation = NAN;
+    } else {
+        valueStatistics.minimum = convertFromTenths(runningValue.minimum);
+        valueStatistics.maximum = convertFromTenths(runningValue.maximum);
+        valueStatistics.mean = static_cast<float>(runningValue.sum) / runningValue.count / 10.0f;
+        // The variance is count * sumOfSquares - sum^2 divided by count^2, the
+        // difference is calculated exactly with 64 bit integers.
+        const int64_t sum = runningValue.sum;
+        const uint64_t difference = runningValue.sumOfSquares * runningValue.count - static_cast<uint64_t>(sum * sum);
+        valueStatistics.standardDeviation = sqrt(static_cast<float>(difference)) / runningValue.count / 10.0f;
+    }
+    return valueStatistics;
 }
 
-    
-uint32_t currentNumberOfRecords()
+
+// Add the values of a stored rollup to a summary.
+//
+void addRollupValueToSummary(const InternalRollupValue &rollupValue, SummaryValue &value)
+{
+    if (rollupValue.count == 0) {
+        return;
+    }
+    if (value.count == 0 || rollupValue.minimum < value.minimum) {
+        value.minimum = rollupValue.minimum;
+    }
+    if (value.count == 0 || rollupValue.maximum > value.maximum) {
+        value.maximum = rollupValue.maximum;
+    }
+    value.count += rollupValue.count;
+    value.sum += static_cast<float>(rollupValue.mean) * rollupValue.count;
+}
+
+
+// Add the rollups of consecutive periods of a tier to a summary.
+//
+// The periods are read in one sequential read, or in two if they wrap
+// around the end of the tier. Periods which are no longer kept by the
+// tier are skipped and mark the summary as incomplete.
+//
+// @param tier The rollup tier.
+// @param firstPeriod The first period to add.
+// @param endPeriod The period after the last one to add.
+// @param total The summary to update.
+//
+void addRollupsToSummary(uint8_t tier, uint32_t firstPeriod, uint32_t endPeriod, SummaryTotal &total)
+{
+    // The newest period of the tier, after a restart it is the one of the newest record.
+    uint32_t newestPeriod = gRollups[tier].period;
+    if (gNextRecord > gFirstRecord) {
+        const uint32_t recordPeriod = getRollupPeriod(tier, gWriteCursor.time);
+        if (newestPeriod == cNoPeriod || recordPeriod > newestPeriod) {
+            newestPeriod = recordPeriod;
+        }
+    }
+    if (newestPeriod == cNoPeriod) {
+        return; // Nothing was added to the tier.
+    }
+    if (endPeriod > (newestPeriod + 1)) {
+        endPeriod = newestPeriod + 1;
+    }
+    const uint8_t capacity = pgm_read_byte(&cRollupCapacities[tier]);
+    if ((newestPeriod + 1) >= capacity && firstPeriod < (newestPeriod + 1 - capacity)) {
+        firstPeriod = newestPeriod + 1 - capacity;
+        total.complete = false;
+    }
+    InternalRollup rollup;
+    for (uint32_t period = firstPeriod; period < endPeriod; ++period) {
+        if (period == firstPeriod || (period % capacity) == 0) {
+            Storage::beginSequentialRead(getRollupStart(tier, period));
+        }
+        Storage::readNextBytes(reinterpret_cast<uint8_t*>(&rollup), sizeof(InternalRollup));
+        if (isRollupForPeriod(tier, period, rollup)) {
+            total.numberOfRecords += rollup.numberOfRecords;
+            addRollupValueToSummary(rollup.temperature, total.temperature);
+            addRollupValueToSummary(rollup.humidity, total.humidity);
+        }
+    }
+    gStreamValid = false;
+}
+
+
+// Add the rollups of a time range to a summary.
+//
+// The range is covered with the full periods of the given tier. The
+// parts before the first and after the last full period are covered
+// with the next shorter tier, so each tier adds at most two runs of
+// consecutive periods.
+//
+// @param tier The longest tier to use.
+// @param startTime The start of the range, at the start of an hour.
+// @param endTime The end of the range, at the start of an hour.
+// @param total The summary to update.
+//
+void addRangeToSummary(uint8_t tier, uint32_t startTime, uint32_t endTime, SummaryTotal &total)
+{
+    if (startTime >= endTime) {
+        return;
+    }
+    const uint32_t length = pgm_read_dword(&cRollupPeriodLengths[tier]);
+    const uint32_t offset = pgm_read_dword(&cRollupPeriodOffsets[tier]);
+    const uint32_t firstPeriod = (startTime + offset + length - 1) / length;
+    const uint32_t endPeriod = (endTime + offset) / length;
+    if (tier == 0) {
+        addRollupsToSummary(tier, firstPeriod, endPeriod, total);
+    } else if (firstPeriod >= endPeriod) {
+        addRangeToSummary(tier - 1, startTime, endTime, total);
+    } else {
+        addRangeToSummary(tier - 1, startTime, firstPeriod * length - offset, total);
+        addRollupsToSummary(tier, firstPeriod, endPeriod, total);
+        addRangeToSummary(tier - 1, endPeriod * length - offset, endTime, total);
+    }
+}
+
+
+// Convert the combined values of a summary into the public structure.
+//
+ValueStatistics getValueStatistics(const SummaryValue &summaryValue)
 {
-    return gCurrentNumberOfRecords;
+    ValueStatistics valueStatistics;
+    valueStatistics.count = summaryValue.count;
+    valueStatistics.standardDeviation = NAN;
+    if (summaryValue.count == 0) {
+        valueStatistics.minimum = NAN;
+        valueStatistics.maximum = NAN;
+        valueStatistics.mean = NAN;
+    } else {
+        valueStatistics.minimum = convertFromTenths(summaryValue.minimum);
+        valueStatistics.maximum = convertFromTenths(summaryValue.maximum);
+        valueStatistics.mean = summaryValue.sum / summaryValue.count / 10.0f;
+    }
+    return valueStatistics;
+}
+
+
+Summary getSummary(const DateTime &start, const DateTime &end)
+{
+    SummaryTotal total;
+    memset(&total, 0, sizeof(SummaryTotal));
+    total.complete = gRollupsEnabled;
+    if (gRollupsEnabled) {
+        // Extend the range to whole hours.
+        const uint32_t hourLength = pgm_read_dword(&cRollupPeriodLengths[0]);
+        const uint32_t startTime = (start.toSecondsSince2000() / hourLength) * hourLength;
+        const uint32_t endTime = ((end.toSecondsSince2000() + hourLength - 1) / hourLength) * hourLength;
+        addRangeToSummary(cRollupTierCount-1, startTime, endTime, total);
+    }
+    Summary summary;
+    summary.numberOfRecords = total.numberOfRecords;
+    summary.temperature = getValueStatistics(total.temperature);
+    summary.humidity = getValueStatistics(total.humidity);
+    summary.complete = total.complete;
+    return summary;
 }
 
 
+Statistics getStatistics(StatisticsRange range)
+{
+    const RunningStatistics &runningStatistics = (range == LastDay) ? gDayStatistics : gAllStatistics;
+    Statistics statistics;
+    statistics.numberOfRecords = runningStatistics.numberOfRecords;
+    statistics.temperature = getValueStatistics(runningStatistics.temperature);
+    statistics.humidity = getValueStatistics(runningStatistics.humidity);
+    return statistics;
 }
+
+
+void setOverwriteOldest(bool enabled)
+{
+    gOverwriteOldest = enabled;
 }
 
 
+void setRecordInterval(uint32_t seconds)
+{
+    gRecordInterval = seconds;
+}
+
+    
+uint32_t maximumNumberOfRecords()
+{
+    return gMaximumNumberOfRecords;
+}
 
+    
+uint32_t currentNumberOfRecords()
+{
+    return gNextRecord - gFirstRecord;
+}
 
 
+}
+}
 
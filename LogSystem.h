@@ -21,6 +21,7 @@
 
 
 #include "DateTime.h"
+#include "config.h"
 
 #include <Arduino.h>
 
@@ -35,12 +36,23 @@ class LogRecord
 public:
     /// Create a new log record using the given values.
     ///
+    /// The values are used for the first channel, all other channels
+    /// have no values (NaN).
+    ///
     /// @param dateTime The time of the record.
     /// @param temperature The temperature in celsius.
     /// @param humidity The humidity as percentage 0-100.
     ///
     LogRecord(const DateTime &dateTime, float temperature, float humidity);
 
+    /// Create a new log record with the values of all channels.
+    ///
+    /// @param dateTime The time of the record.
+    /// @param temperatures The temperatures in celsius, one for each channel.
+    /// @param humidities The humidities as percentage 0-100, one for each channel.
+    ///
+    LogRecord(const DateTime &dateTime, const float *temperatures, const float *humidities);
+
     /// Create a special null record.
     ///
     /// This records are used in error situations.
@@ -62,23 +74,34 @@ public:
     
     /// Get the temperature of the record in celsius.
     ///
-    inline float getTemperature() const { return _temperature; }
+    /// @param channel The sensor channel, the first one by default.
+    ///
+    inline float getTemperature(uint8_t channel = 0) const { return _temperatures[channel]; }
     
     /// Get the humidity of the record in percent 0-100.
     ///
-    inline float getHumidity() const { return _humidity; }
+    /// @param channel The sensor channel, the first one by default.
+    ///
+    inline float getHumidity(uint8_t channel = 0) const { return _humidities[channel]; }
     
     /// Write this record to the serial interface.
     ///
     /// The format is: date/time, temperature, humidity
     /// Example: 2015-08-22 12:42:21,80,25
+    /// With more than one channel, the temperature and humidity of
+    /// each channel follow in the order of the channels.
     ///
     void writeToSerial() const;
     
+private:
+    /// Set the values of one channel, limited to the valid range.
+    ///
+    void setValues(uint8_t channel, float temperature, float humidity);
+    
 private:
     DateTime _dateTime;
-    float _temperature;
-    float _humidity;
+    float _temperatures[SENSOR_CHANNEL_COUNT];
+    float _humidities[SENSOR_CHANNEL_COUNT];
 };
 
 
@@ -90,10 +113,24 @@ namespace LogSystem {
 
 /// Initialize the log system
 ///
+/// The end of the log is found using the persisted head, which is
+/// verified against the last block of the log. Only if the head is
+/// invalid, the headers of all blocks are scanned for the oldest
+/// and the newest block. The statistics are restored from their
+/// persisted copy, they are only calculated from all records if this
+/// copy is invalid.
+///
+/// On memory with limited write endurance, the head and the statistics
+/// are not persisted.
+///
 void begin(uint32_t reservedForConfig);
 
 /// Get the maximum number of records for the given storage.
 ///
+/// The records are stored delta-compressed in blocks. A block is closed
+/// early if a record differs too much from the previous one, therefore
+/// this number is an upper limit.
+///
 uint32_t maximumNumberOfRecords();
 
 /// Get the number of records currently in the storage.
@@ -102,22 +139,163 @@ uint32_t currentNumberOfRecords();
 
 /// Read a record from the storage.
 ///
+/// @param index The index of the record, where 0 is the oldest record
+///    in the storage.
+///
 LogRecord getLogRecord(uint32_t index);
 
+/// Find the first record at or after the given time.
+///
+/// This is a binary search over the block headers, followed by a short
+/// scan in the found block. It requires increasing times in the log.
+///
+/// @param dateTime The time to search for.
+/// @return The index of the record, or currentNumberOfRecords() if all
+///    records are before the given time.
+///
+uint32_t findFirstRecordAtOrAfter(const DateTime &dateTime);
+
+/// An iterator over all records in a time range.
+///
+/// The first record is found using findFirstRecordAtOrAfter(), all
+/// following records are read in sequence.
+///
+class RangeIterator
+{
+public:
+    /// Create an iterator without records.
+    ///
+    RangeIterator();
+    
+    /// Create an iterator for a time range.
+    ///
+    /// @param start The start of the range (inclusive).
+    /// @param end The end of the range (exclusive).
+    ///
+    RangeIterator(const DateTime &start, const DateTime &end);
+    
+    /// dtor
+    ///
+    ~RangeIterator();
+    
+public:
+    /// Read the next record in the range.
+    ///
+    /// @param logRecord The variable to store the record.
+    /// @return true if a record was read, false at the end of the range.
+    ///
+    bool next(LogRecord &logRecord);
+    
+    /// Get the index of the next record.
+    ///
+    inline uint32_t getIndex() const { return _index; }
+    
+private:
+    uint32_t _index;
+    DateTime _end;
+};
+
 /// Append a record to the storage.
 ///
-/// This will first zero the record (index+1) if possible, before
-/// writing the given record to (index).
+/// The record is stored as difference to the previous record in the
+/// current block. If this is not possible, a new block is started.
+/// Temperature and humidity are stored with a resolution of 1/10.
+///
+/// If the storage is full and overwriting is enabled, the block with
+/// the oldest records is dropped and reused.
+///
+/// The sample and the head are written in the background, if the
+/// storage backend supports it.
 ///
 /// @param logRecord The record to append.
 /// @return true on success, false if the storage is full.
 ///
 bool appendRecord(const LogRecord &logRecord);
 
+/// The range of the statistics.
+///
+enum StatisticsRange : uint8_t {
+    AllRecords, ///< All records in the log.
+    LastDay ///< The records of the 24 hours up to the newest record.
+};
+
+/// The statistics of one value.
+///
+/// All values except the count are NAN if there are no values.
+///
+struct ValueStatistics {
+    uint32_t count; ///< The number of records with this value.
+    float minimum; ///< The minimum value.
+    float maximum; ///< The maximum value.
+    float mean; ///< The mean value.
+    float standardDeviation; ///< The standard deviation of all values.
+};
+
+/// The statistics of the records in a range.
+///
+struct Statistics {
+    uint32_t numberOfRecords; ///< The number of records in the range.
+    ValueStatistics temperature; ///< The statistics of the temperature in celsius.
+    ValueStatistics humidity; ///< The statistics of the humidity in percent.
+};
+
+/// Get the statistics of all records or of the last day.
+///
+/// The statistics are restored in begin() and updated with each
+/// appended record, so this call does not read the storage.
+///
+Statistics getStatistics(StatisticsRange range);
+
+/// The summary of all records in a time range.
+///
+struct Summary {
+    uint32_t numberOfRecords; ///< The number of records in the range.
+    ValueStatistics temperature; ///< The temperature in celsius, without standard deviation.
+    ValueStatistics humidity; ///< The humidity in percent, without standard deviation.
+    bool complete; ///< false if parts of the range are older than the kept periods.
+};
+
+/// Get the summary of all records in a time range.
+///
+/// The log keeps the minimum, maximum and mean values for each hour
+/// of the last day, each day of the last month and each week of the
+/// last year. The range is covered with the longest periods which fit
+/// into it and the shorter periods at its ends, so each tier is read
+/// in at most two runs without reading the records. If a part of the
+/// range is older than the periods kept by its tier, it is missing
+/// and the summary is not complete.
+///
+/// @param start The start of the range (inclusive), which is
+///    extended to the start of the hour.
+/// @param end The end of the range (exclusive), which is
+///    extended to the end of the hour.
+///
+Summary getSummary(const DateTime &start, const DateTime &end);
+
+/// Set if the oldest records are overwritten if the storage is full.
+///
+/// @param enabled true to use the storage as ring buffer, false to
+///    stop appending records if the storage is full.
+///
+void setOverwriteOldest(bool enabled);
+
+/// Set the interval between two records.
+///
+/// The first record of each block stores the interval as the expected
+/// time to the next record, so the following samples only store the
+/// deviation from it. Without an interval, the time between the last
+/// two records is used, which is not known for the first block and
+/// after a gap in the log.
+///
+/// @param seconds The interval in seconds, or 0 if it is not known.
+///
+void setRecordInterval(uint32_t seconds);
+
 /// Format the storage.
 ///
-/// This will set the initial two records of the storage area to zero.
-/// It is enough to initialize the storage with minimum number of writes.
+/// This will reset the persisted head and set the headers of all
+/// blocks to zero. It is enough to initialize the storage
+/// with minimum number of writes.
 ///
 void format();
     
@@ -32,28 +32,42 @@ namespace MainMenuView {
 // The items in the start menu.
 static const char cItem1[] PROGMEM = "Start Rec.";
 static const char cItem2[] PROGMEM = "View Records";
-static const char cItem3[] PROGMEM = "Send Records";
-static const char cItem4[] PROGMEM = "Set Interval";
-static const char cItem5[] PROGMEM = "Erase All";
-static const char cItem6[] PROGMEM = "Adjust Time";
-static const char cItem7[] PROGMEM = "Version Info";
-static const char *cItems[7] = {cItem1, cItem2, cItem3, cItem4, cItem5, cItem6, cItem7};
-static const uint8_t cItemCount = 7;
+static const char cItem3[] PROGMEM = "Statistics";
+static const char cItem4[] PROGMEM = "Trend Chart";
+static const char cItem5[] PROGMEM = "Send Records";
+static const char cItem6[] PROGMEM = "Set Interval";
+static const char cItem7[] PROGMEM = "Log Mode";
+static const char cItem8[] PROGMEM = "Erase All";
+static const char cItem9[] PROGMEM = "Adjust Time";
+static const char cItem10[] PROGMEM = "Version Info";
+static const char *cItems[10] = {cItem1, cItem2, cItem3, cItem4, cItem5, cItem6, cItem7, cItem8, cItem9, cItem10};
+static const uint8_t cItemCount = 10;
 
 // The currently selected item.
 static uint8_t gSelectedItem = 0;
 
+// The first visible item, if the menu is scrolled.
+static uint8_t gFirstVisibleItem = 0;
+
+
+// Get the number of visible items.
+inline uint8_t getVisibleLines()
+{
+    return SharpDisplay::getScreenHeight()-5;
+}
+
     
 void updateDisplay()
 {
     SharpDisplay::setTextInverse(false);
     SharpDisplay::setLineText(0, PSTR("Main Menu"));
     SharpDisplay::fillRow(1, '\x89');
-    const uint8_t visibleLines = SharpDisplay::getScreenHeight()-5;
+    const uint8_t visibleLines = getVisibleLines();
     for (uint8_t i = 0; i < visibleLines; ++i) {
-        if (i < cItemCount) {
-            SharpDisplay::setTextInverse(i == gSelectedItem);
-            SharpDisplay::setLineText(i+2, cItems[i]);
+        const uint8_t item = gFirstVisibleItem + i;
+        if (item < cItemCount) {
+            SharpDisplay::setTextInverse(item == gSelectedItem);
+            SharpDisplay::setLineText(i+2, cItems[item]);
         } else {
             SharpDisplay::setTextInverse(false);
             SharpDisplay::fillRow(i+2, ' ');
@@ -66,19 +80,28 @@ void handleKey(KeyPad::Key key)
 {
     if (key == KeyPad::Down && gSelectedItem < (cItemCount-1)) {
         ++gSelectedItem;
+        if (gSelectedItem >= gFirstVisibleItem + getVisibleLines()) {
+            ++gFirstVisibleItem;
+        }
         ViewManager::setNeedsDisplayUpdate();
     } else if (key == KeyPad::Up && gSelectedItem > 0) {
         --gSelectedItem;
+        if (gSelectedItem < gFirstVisibleItem) {
+            gFirstVisibleItem = gSelectedItem;
+        }
         ViewManager::setNeedsDisplayUpdate();
     } else if (key == KeyPad::Enter || key == KeyPad::Right) {
         switch (gSelectedItem) {
             case 0: ViewManager::setNextView(ViewManager::RecordView); break;
             case 1: ViewManager::setNextView(ViewManager::ViewRecordView); break;
-            case 2: ViewManager::setNextView(ViewManager::SendRecordView); break;
-            case 3: ViewManager::setNextView(ViewManager::SetIntervalView); break;
-            case 4: ViewManager::setNextView(ViewManager::EraseAllView); break;
-            case 5: ViewManager::setNextView(ViewManager::AdjustTimeView); break;
-            case 6: ViewManager::setNextView(ViewManager::VersionInfoView); break;
+            case 2: ViewManager::setNextView(ViewManager::StatisticsView); break;
+            case 3: ViewManager::setNextView(ViewManager::ChartView); break;
+            case 4: ViewManager::setNextView(ViewManager::SendRecordView); break;
+            case 5: ViewManager::setNextView(ViewManager::SetIntervalView); break;
+            case 6: ViewManager::setNextView(ViewManager::LogModeView); break;
+            case 7: ViewManager::setNextView(ViewManager::EraseAllView); break;
+            case 8: ViewManager::setNextView(ViewManager::AdjustTimeView); break;
+            case 9: ViewManager::setNextView(ViewManager::VersionInfoView); break;
         }
     }
 }
@@ -34,6 +34,7 @@ namespace SendRecordView {
 
 // The state of this view.    
 enum State : uint8_t {
+    StateSelectRange,
     StateInitialize,
     StateWelcome,
     StateWrite,
@@ -41,24 +42,59 @@ enum State : uint8_t {
 };
 
     
-static State gState = StateInitialize; // The state of the view.
+// The names of the ranges to send.
+static const char cRange1[] PROGMEM = "All Records";
+static const char cRange2[] PROGMEM = "Last 24h";
+static const char cRange3[] PROGMEM = "Last 7 Days";
+static const char cRange4[] PROGMEM = "Last 30 Days";
+static const char *cRanges[4] = {cRange1, cRange2, cRange3, cRange4};
+static const uint8_t cRangeCount = 4;
+
+// The number of days for each range, 0 for all records.
+static const uint8_t cRangeDays[4] PROGMEM = {0, 1, 7, 30};
+
+    
+static State gState = StateSelectRange; // The state of the view.
 static uint32_t gTime; // The time to calculate delays.
-static uint32_t gSentRecord; // The last sent record index.
+static uint32_t gSentRecord; // The number of sent records.
 static uint32_t gSerialSpeed; // The speed of the serial port.
+static uint8_t gSelectedRange; // The selected range.
+static LogSystem::RangeIterator gRangeIterator; // The iterator over the records to send.
     
     
 void viewWillAppear()
 {
-    gState = StateInitialize;
-    gTime = millis();
-    gSentRecord = 0;
+    gState = StateSelectRange;
+    gSelectedRange = 0;
     gSerialSpeed = Settings::getSerialSpeed();
 }
 
+
+// Start to send the records of the selected range.
+//
+// The first record of the range is found with a binary search,
+// the range ends with the newest record.
+//
+void startSending()
+{
+    DateTime start;
+    const uint8_t days = pgm_read_byte(&cRangeDays[gSelectedRange]);
+    const uint32_t numberOfRecords = LogSystem::currentNumberOfRecords();
+    if (days > 0 && numberOfRecords > 0) {
+        start = LogSystem::getLogRecord(numberOfRecords-1).getDateTime().addDays(-static_cast<int32_t>(days));
+    }
+    gRangeIterator = LogSystem::RangeIterator(start, DateTime(2199, 12, 31, 23, 59, 59));
+    gSentRecord = 0;
+    gTime = millis();
+    gState = StateInitialize;
+}
+
     
 void handleLoop()
 {
-    if (gState == StateInitialize) {
+    if (gState == StateSelectRange) {
+        return;
+    } else if (gState == StateInitialize) {
         Serial.begin(gSerialSpeed);
         gState = StateWelcome;
         ViewManager::setNeedsDisplayUpdate();
@@ -70,12 +106,12 @@ void handleLoop()
     } else if (gState == StateWrite) {
         gTime = millis();
         while ((millis() - gTime) < 100) {
-            if (gSentRecord >= LogSystem::currentNumberOfRecords()) {
+            LogRecord logRecord;
+            if (!gRangeIterator.next(logRecord)) {
                 gState = StateDone;
                 gTime = millis();
                 break;
             }
-            LogRecord logRecord = LogSystem::getLogRecord(gSentRecord);
             logRecord.writeToSerial();
             ++gSentRecord;
         }
@@ -90,6 +126,20 @@ void handleLoop()
     
 void updateDisplay()
 {
+    if (gState == StateSelectRange) {
+        SharpDisplay::setLineText(0, PSTR("Send Records"));
+        SharpDisplay::fillRow(1, '\x89');
+        for (uint8_t i = 0; i < 7; ++i) {
+            String text;
+            if (i < cRangeCount) {
+                text = String(reinterpret_cast<const __FlashStringHelper*>(cRanges[i]));
+            }
+            SharpDisplay::setTextInverse(i == gSelectedRange);
+            SharpDisplay::setLineText(i+2, text);
+        }
+        SharpDisplay::setTextInverse(false);
+        return;
+    }
     SharpDisplay::clearRows(0, 9);
     if (gState == StateInitialize || gState == StateWelcome) {
         SharpDisplay::setLineText(3, PSTR("Sending Data"));
@@ -98,13 +148,45 @@ void updateDisplay()
     } else if (gState == StateWrite) {
         SharpDisplay::setLineText(3, PSTR("Send Record:"));
         const uint32_t numberOfRecords = LogSystem::currentNumberOfRecords();
-        SharpDisplay::setLineText(4, String(gSentRecord, DEC) + '/' + String(numberOfRecords, DEC));
+        SharpDisplay::setLineText(4, String(gRangeIterator.getIndex(), DEC) + '/' + String(numberOfRecords, DEC));
     } else if (gState == StateDone) {
         SharpDisplay::setLineText(4, PSTR("  Success!  "));
     }
 }
 
+
+void handleKey(KeyPad::Key key)
+{
+    if (gState != StateSelectRange) {
+        return;
+    }
+    switch (key) {
+        case KeyPad::Up:
+            if (gSelectedRange > 0) {
+                --gSelectedRange;
+            }
+            break;
+            
+        case KeyPad::Down:
+            if (gSelectedRange < (cRangeCount-1)) {
+                ++gSelectedRange;
+            }
+            break;
+            
+        case KeyPad::Enter:
+            startSending();
+            break;
+            
+        case KeyPad::Left:
+            ViewManager::setNextView(ViewManager::MainMenuView);
+            break;
+            
+        default:
+            break;
+    }
+    ViewManager::setNeedsDisplayUpdate();
+}
+
     
 }
 }
-
@@ -20,6 +20,7 @@
 //
 
 
+#include "KeyPad.h"
 #include "ViewManager.h"
 
 
@@ -28,6 +29,7 @@ namespace SendRecordView {
     
     
 void updateDisplay();
+void handleKey(KeyPad::Key key);
 void handleLoop();
 void viewWillAppear();
     
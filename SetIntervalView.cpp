@@ -21,6 +21,7 @@
 
 
 #include "Application.h"
+#include "LogSystem.h"
 #include "Settings.h"
 #include "SharpDisplay.h"
 #include "ViewManager.h"
@@ -91,6 +92,8 @@ void handleKey(KeyPad::Key key)
             
         case KeyPad::Enter:
             Settings::setInterval(static_cast<Settings::Interval>(gSelectedIndex));
+            LogSystem::setRecordInterval(Settings::getIntervalInSeconds());
+            // fall through
         case KeyPad::Left:
             ViewManager::setNextView(ViewManager::MainMenuView);
             break;
@@ -32,6 +32,7 @@ namespace Settings {
 struct Data {
     Interval interval; ///< The recording interval.
     SerialSpeed serialSpeed; ///< The serial speed.
+    LogMode logMode; ///< The behaviour if the log is full.
     uint16_t crc; ///< The CRC-16 of the data.
 };
 
@@ -49,6 +50,7 @@ void resetToDefault()
 {
     gData.interval = I1h;
     gData.serialSpeed = S9600;
+    gData.logMode = StopWhenFull;
 }
 
 
@@ -64,6 +66,7 @@ void saveToStorage()
     gData.crc = crc;
     // Save the data block to the storage.
     Storage::writeBytes(0, dataPtr, sizeof(Data));
+    Storage::flush();
 }
 
 
@@ -132,6 +135,19 @@ SerialSpeed getSerialSpeed()
     return gData.serialSpeed;
 }
 
+
+void setLogMode(LogMode logMode)
+{
+    gData.logMode = logMode;
+    saveToStorage();
+}
+
+
+LogMode getLogMode()
+{
+    return gData.logMode;
+}
+
     
 }
 }
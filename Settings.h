@@ -62,6 +62,14 @@ enum SerialSpeed : uint32_t {
 };
 
 
+/// The behaviour of the log if the storage is full.
+///
+enum LogMode : uint8_t {
+    StopWhenFull = 0, ///< Stop recording.
+    OverwriteOldest ///< Overwrite the oldest records.
+};
+
+
 /// Initialize the settings, read them from the storage.
 ///
 void begin();
@@ -93,6 +101,14 @@ void setSerialSpeed(SerialSpeed speed);
 /// Get the current serial speed.
 ///
 SerialSpeed getSerialSpeed();
+
+/// Set the log mode.
+///
+void setLogMode(LogMode logMode);
+
+/// Get the current log mode.
+///
+LogMode getLogMode();
     
     
 }
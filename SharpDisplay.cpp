@@ -20,6 +20,9 @@
 #include "SharpDisplay.h"
 
 
+#include "KeyPad.h"
+
+
 #include <avr/interrupt.h>
 
 
@@ -47,6 +50,13 @@ static uint8_t gClockMask;
 static uint8_t gDataPin;
 static volatile uint8_t *gDataPort;
 static uint8_t gDataMask;
+static SharpDisplay::Interface gInterface;
+
+// The fixed pins of the hardware interfaces.
+static const uint8_t gSpiClockPin = 13;
+static const uint8_t gSpiDataPin = 11;
+static const uint8_t gUsartClockPin = 4;
+static const uint8_t gUsartDataPin = 1;
    
     
 // This constants are bitmasks for the commands
@@ -58,13 +68,51 @@ static const uint8_t CMD_VCOM = 0x40;
 // This flag is used to toggle the required VCOM bit.
 static uint8_t gVComBit;
 
+
+// The states of a transfer to the display.
+enum TransferState : uint8_t {
+    TransferIdle, // There is no transfer.
+    TransferCommand, // The command is next.
+    TransferAddress, // The address of a pixel row is next.
+    TransferData, // The pixels of a row are next.
+    TransferRowEnd, // The trailer of a pixel row is next.
+    TransferEnd, // The trailer of the transfer is next.
+    TransferFinish // All bytes are sent, the transfer ends after the last one.
+};
+
+// The current transfer.
+static volatile TransferState gTransferState;
+static uint8_t gTransferCommand;
+static bool gTransferAllRows;
+static uint8_t gTransferInvertMask;
+static uint8_t gTransferRow;
+static uint8_t gTransferPixelRow;
+static uint8_t gTransferPixelRowMask;
+static uint8_t gTransferColumn;
+
+// This flag is set if the display has to be cleared with the next transfer.
+static bool gClearRequested;
+
+// The number of running changes of the screen from the main loop.
+// While the screen is changed, no rows are sent to the display.
+static volatile uint8_t gScreenLockCount;
+
+// The maximum number of pixel rows sent in one interrupt using the software interface.
+static uint8_t gMaximumPixelRowsPerInterrupt = 16;
+
+// If the refresh from the timer interrupt is paused.
+static volatile bool gRefreshPaused;
+
+// If a transfer using a hardware interface waits for the end of the pause.
+static volatile bool gTransferStalled;
+
     
 // The array with the 12x12 screen.
 static const uint8_t gScreenHeight = 12;
 static const uint8_t gScreenWidth = 12;
 static uint8_t gScreenCharacters[gScreenHeight*gScreenWidth];
-static const uint8_t gScreenRowRequiresUpdateSize = gScreenHeight/8+1;
-static uint8_t gScreenRowRequiresUpdate[gScreenRowRequiresUpdateSize];
+// For each row, one bit for each pixel row which requires an update.
+static uint8_t gScreenRowRequiresUpdate[gScreenHeight];
     
 // The height of a single character.
 static const uint8_t gCharacterHeight = 8;
@@ -83,6 +131,22 @@ static uint8_t gTextFlags;
 // The cursor position
 static uint8_t gCursorX;
 static uint8_t gCursorY;
+
+// The chart, which replaces a range of text rows.
+// Each pixel column of the chart is a vertical line from the value of
+// the previous column to its own value, which is streamed out like a
+// text row. The characters of the chart rows are not shown, so they
+// store the values, one byte for each column: 0 for no value, or the
+// pixel row of the value plus one.
+static const uint8_t gChartWidth = 96;
+static uint8_t gChartFirstRow;
+static uint8_t gChartRowCount;
+
+// The pixels of the text row in transfer.
+// The row is rendered once at the start of its transfer, so sending
+// a byte is just reading it from this buffer. A cache of the whole
+// screen would need 1152 bytes, which is more than the RAM left.
+static uint8_t gRowPixels[gCharacterHeight*gScreenWidth];
     
     
 // Set the clock low
@@ -130,29 +194,26 @@ static void sendByteMSB(uint8_t byte)
 }
 
     
-// This method sends a single byte LSB first to the display
-static void sendByteLSB(uint8_t byte)
-{
-    for (uint8_t i = 0; i < 8; ++i) {
-        setClockLow();
-        if (byte & 0x01) {
-            setDataHigh();
-        } else {
-            setDataLow();
-        }
-        setClockHigh();
-        byte >>= 1;
-    }
-    setClockLow();
-}
-
-    
 // This method toggles the VCOM bit
 inline static void toggleVComBit()
 {
     gVComBit ^= CMD_VCOM;
 }
 
+
+// Reverse the bit order of a byte.
+//
+// The display expects the row addresses LSB first. All bytes are sent
+// MSB first, therefore the addresses are reversed before sending them.
+//
+inline uint8_t reverseBits(uint8_t byte)
+{
+    byte = (byte >> 4) | (byte << 4);
+    byte = ((byte & 0xcc) >> 2) | ((byte & 0x33) << 2);
+    byte = ((byte & 0xaa) >> 1) | ((byte & 0x55) << 1);
+    return byte;
+}
+
     
 // This method calculates a pointer to a character on the screen
 inline uint8_t* getCharacterPosition(uint8_t row, uint8_t column)
@@ -171,30 +232,186 @@ inline void clearScreen()
 // Check if a given row is maked for updates
 inline bool isRowMarkedForUpdate(uint8_t row)
 {
-    return ((gScreenRowRequiresUpdate[row>>3] & (1<<(row&7))) != 0);
+    return gScreenRowRequiresUpdate[row] != 0;
 }
     
     
 // Mark a given row for an update
 inline void markRowForUpdate(uint8_t row)
 {
-    gScreenRowRequiresUpdate[row>>3] |= (1<<(row&7));
+    gScreenRowRequiresUpdate[row] = 0xff;
+}
+
+
+// Mark the given pixel rows of a row for an update
+inline void markPixelRowsForUpdate(uint8_t row, uint8_t pixelRowMask)
+{
+    gScreenRowRequiresUpdate[row] |= pixelRowMask;
 }
 
     
+// Remove the update mark from a given row
+inline void unmarkRowForUpdate(uint8_t row)
+{
+    gScreenRowRequiresUpdate[row] = 0x00;
+}
+
+
 // Mark the whole screen for an update.
 inline void markScreenForUpdate()
 {
-    memset(gScreenRowRequiresUpdate, 0xff, gScreenRowRequiresUpdateSize);
+    memset(gScreenRowRequiresUpdate, 0xff, gScreenHeight);
 }
 
  
 // Remove any row update requests from the screen.
 inline void clearScreenUpdate()
 {
-    memset(gScreenRowRequiresUpdate, 0x00, gScreenRowRequiresUpdateSize);
+    memset(gScreenRowRequiresUpdate, 0x00, gScreenHeight);
+}
+
+// Get the values of the chart columns, stored in the characters of the chart rows.
+inline uint8_t* getChartValues()
+{
+    return getCharacterPosition(gChartFirstRow, 0);
+}
+
+
+// Get the number of pixel columns of the chart, limited by the stored values.
+inline uint8_t getChartColumnCount()
+{
+    const uint8_t count = gChartRowCount*gScreenWidth;
+    return (count < gChartWidth) ? count : gChartWidth;
+}
+
+
+// Clear all columns of the chart.
+//
+// This also empties the characters of the chart rows, which show text
+// again if the chart is moved.
+//
+inline void clearChartColumns()
+{
+    memset(getChartValues(), 0x00, gChartRowCount*gScreenWidth);
+}
+
+
+// Get the line of a pixel column of the chart.
+//
+// @return false if the column is empty.
+//
+inline bool getChartLine(uint8_t x, uint8_t &top, uint8_t &bottom)
+{
+    const uint8_t *values = getChartValues();
+    if (values[x] == 0) {
+        return false;
+    }
+    top = values[x]-1;
+    bottom = top;
+    if (x > 0 && values[x-1] != 0) {
+        const uint8_t previous = values[x-1]-1;
+        if (previous < top) {
+            top = previous;
+        } else {
+            bottom = previous;
+        }
+    }
+    return true;
+}
+
+
+// Check if a given row is part of the chart.
+inline bool isChartRow(uint8_t row)
+{
+    return row >= gChartFirstRow && row < (gChartFirstRow+gChartRowCount);
+}
+
+
+// Mark all rows of the chart for an update.
+inline void markChartForUpdate()
+{
+    for (uint8_t row = gChartFirstRow; row < (gChartFirstRow+gChartRowCount); ++row) {
+        markRowForUpdate(row);
+    }
 }
 
+
+// Mark the pixel rows of the chart from top to bottom for an update.
+inline void markChartPixelRowsForUpdate(uint8_t top, uint8_t bottom)
+{
+    const uint8_t height = gChartRowCount*gCharacterHeight;
+    if (bottom >= height) {
+        bottom = height-1;
+    }
+    for (uint8_t y = top; y <= bottom && y < height; ++y) {
+        markPixelRowsForUpdate(gChartFirstRow+(y/gCharacterHeight), 1<<(y%gCharacterHeight));
+    }
+}
+
+
+// Mark the lines of a pixel column and the following column for an update.
+inline void markChartColumnForUpdate(uint8_t column)
+{
+    const uint8_t columnCount = getChartColumnCount();
+    for (uint8_t x = column; x <= column+1 && x < columnCount; ++x) {
+        uint8_t top;
+        uint8_t bottom;
+        if (getChartLine(x, top, bottom)) {
+            markChartPixelRowsForUpdate(top, bottom);
+        }
+    }
+}
+
+
+// Render the lines of all pixel columns into the row buffer.
+inline void renderChartRow(uint8_t row)
+{
+    memset(gRowPixels, 0xff, sizeof(gRowPixels));
+    const uint8_t firstY = (row-gChartFirstRow)*gCharacterHeight;
+    const uint8_t columnCount = getChartColumnCount();
+    for (uint8_t x = 0; x < columnCount; ++x) {
+        uint8_t top;
+        uint8_t bottom;
+        if (getChartLine(x, top, bottom) && top < (firstY+gCharacterHeight) && bottom >= firstY) {
+            const uint8_t bit = 0x80 >> (x & 0x07);
+            uint8_t *pixels = gRowPixels + (x >> 3);
+            for (uint8_t pixelRow = 0; pixelRow < gCharacterHeight; ++pixelRow) {
+                const uint8_t y = firstY+pixelRow;
+                if (top <= y && y <= bottom) {
+                    *pixels &= ~bit;
+                }
+                pixels += gScreenWidth;
+            }
+        }
+    }
+}
+
+
+// Render all pixels of a row into the row buffer.
+//
+// The buffer contains the pixel rows one after the other, each
+// with one byte for each column.
+//
+void renderRow(uint8_t row)
+{
+    if (isChartRow(row)) {
+        renderChartRow(row);
+        return;
+    }
+    const uint8_t *screenData = getCharacterPosition(row, 0);
+    for (uint8_t column = 0; column < gScreenWidth; ++column) {
+        const uint8_t characterIndex = (screenData[column] & gTextCharacterMask);
+        const uint8_t *glyph = gTextFont + (static_cast<uint16_t>(characterIndex) * gCharacterHeight);
+        const uint8_t invertMask = ((screenData[column] & gTextFlagInverse) != 0) ? 0xff : 0x00;
+        uint8_t *pixels = gRowPixels + column;
+        for (uint8_t pixelRow = 0; pixelRow < gCharacterHeight; ++pixelRow) {
+            *pixels = pgm_read_byte(glyph++) ^ invertMask;
+            pixels += gScreenWidth;
+        }
+    }
+}
+
+
 // A simple class to lock the interrupt and make sure it is enabled if
 // the method ends.
 class LockInterrupt {
@@ -206,74 +423,261 @@ public:
         sei();
     }
 };
+
+
+// A simple class to lock the screen while it is changed.
+//
+// Interrupts stay enabled. The interrupts do not start a refresh and
+// end a running one at the next row while the screen is locked, so
+// they never send a partly changed row. The skipped rows stay marked
+// and are sent with the next refresh.
+//
+class LockScreen {
+public:
+    LockScreen() {
+        ++gScreenLockCount;
+        asm volatile ("" ::: "memory"); // Keep all changes after the lock.
+    }
+    ~LockScreen() {
+        asm volatile ("" ::: "memory"); // Keep all changes before the unlock.
+        --gScreenLockCount;
+    }
+};
+
+
+// Check if the screen is locked.
+inline bool isScreenLocked()
+{
+    return gScreenLockCount != 0;
+}
     
     
-void refreshDisplay()
+// Find the next row to send, starting at the current transfer row.
+//
+// The found row is rendered and its update mark is removed. If the row
+// changes while it is sent, it is marked again and sent with the next
+// refresh. If the screen is locked, the transfer ends.
+//
+bool findNextTransferRow()
 {
-    // Send the write command.
-    digitalWrite(gChipSelectPin, HIGH);
-    sendByteMSB(CMD_WRITE|gVComBit);
-    toggleVComBit();
-    // Update all rows which need a refresh.
-    for (uint8_t row = 0; row < gScreenHeight; ++row) {
-        if (isRowMarkedForUpdate(row)) {
-            // Draw the row pixel row by pixel row
-            for (uint8_t pixelRow = 0; pixelRow < gCharacterHeight; ++pixelRow) {
-                sendByteLSB(row*gCharacterHeight+pixelRow+1);
-                for (uint8_t column = 0; column < gScreenWidth; ++column) {
-                    const uint8_t screenData = *(getCharacterPosition(row, column));
-                    const uint8_t characterIndex = (screenData & gTextCharacterMask);
-                    uint16_t characterStart = characterIndex;
-                    characterStart *= gCharacterHeight;
-                    characterStart += pixelRow;
-                    uint8_t pixelMask = pgm_read_byte(gTextFont+characterStart);
-                    if ((screenData & gTextFlagInverse) != 0) { // Inverse character?
-                        pixelMask = ~pixelMask;
-                    }
-                    sendByteMSB(pixelMask);
-                }
-                sendByteLSB(0x00);
+    if (isScreenLocked()) {
+        return false;
+    }
+    while (gTransferRow < gScreenHeight) {
+        if (gTransferAllRows || isRowMarkedForUpdate(gTransferRow)) {
+            gTransferPixelRowMask = (gTransferAllRows ? 0xff : gScreenRowRequiresUpdate[gTransferRow]);
+            unmarkRowForUpdate(gTransferRow);
+            renderRow(gTransferRow);
+            return true;
+        }
+        ++gTransferRow;
+    }
+    return false;
+}
+
+
+// Find the next pixel row to send, starting at the current transfer pixel row.
+//
+// Only the marked pixel rows of a row are sent, continuing with the
+// next row after the last one.
+//
+bool findNextTransferPixelRow()
+{
+    while (true) {
+        while (gTransferPixelRow < gCharacterHeight) {
+            if ((gTransferPixelRowMask & (1<<gTransferPixelRow)) != 0) {
+                return true;
+            }
+            ++gTransferPixelRow;
+        }
+        gTransferPixelRow = 0;
+        ++gTransferRow;
+        if (!findNextTransferRow()) {
+            return false;
+        }
+    }
+}
+
+
+// Get the next byte of the current transfer.
+//
+// All bytes are prepared to be sent MSB first.
+//
+// @param byte The variable to store the byte.
+// @return true if there is a byte, false at the end of the transfer.
+//
+bool getNextTransferByte(uint8_t &byte)
+{
+    switch (gTransferState) {
+        case TransferCommand:
+            byte = gTransferCommand|gVComBit;
+            toggleVComBit();
+            gTransferRow = 0;
+            gTransferPixelRow = 0;
+            if (gTransferCommand == CMD_WRITE && findNextTransferRow() && findNextTransferPixelRow()) {
+                gTransferState = TransferAddress;
+            } else {
+                gTransferState = TransferEnd;
+            }
+            return true;
+            
+        case TransferAddress:
+            byte = reverseBits(gTransferRow*gCharacterHeight+gTransferPixelRow+1);
+            gTransferColumn = 0;
+            gTransferState = TransferData;
+            return true;
+            
+        case TransferData:
+            byte = gRowPixels[gTransferPixelRow*gScreenWidth+gTransferColumn] ^ gTransferInvertMask;
+            if (++gTransferColumn == gScreenWidth) {
+                gTransferState = TransferRowEnd;
             }
+            return true;
+            
+        case TransferRowEnd:
+            byte = 0x00;
+            ++gTransferPixelRow;
+            gTransferState = findNextTransferPixelRow() ? TransferAddress : TransferEnd;
+            return true;
+            
+        case TransferEnd:
+            byte = 0x00;
+            gTransferState = TransferFinish;
+            return true;
+            
+        case TransferFinish:
+            gTransferState = TransferIdle;
+            return false;
+            
+        default:
+            return false;
+    }
+}
+
+
+// Write a byte to the hardware interface.
+inline void writeHardwareByte(uint8_t byte)
+{
+    if (gInterface == SharpDisplay::HardwareSpiInterface) {
+        SPDR = byte;
+    } else {
+        UDR0 = byte;
+    }
+}
+
+
+// Send the next pixel rows of a transfer using the software interface.
+//
+// At most gMaximumPixelRowsPerInterrupt pixel rows are sent, the
+// transfer is continued with the next timer interrupt. The chip
+// select signal stays high in the meantime.
+//
+void sendTransferChunk()
+{
+    uint8_t pixelRowCount = 0;
+    uint8_t byte;
+    while (true) {
+        const bool isRowEnd = (gTransferState == TransferRowEnd);
+        if (!getNextTransferByte(byte)) {
+            break;
+        }
+        sendByteMSB(byte);
+        if (isRowEnd && ++pixelRowCount >= gMaximumPixelRowsPerInterrupt) {
+            return;
         }
     }
-    sendByteLSB(0x00);
     digitalWrite(gChipSelectPin, LOW);
-    clearScreenUpdate();
+}
+
+
+// Send the next byte of a transfer using the hardware interface.
+//
+// This is called from the transfer complete interrupt of the hardware.
+// While the refresh is paused, the transfer stalls until the pause ends.
+//
+void sendNextTransferByte()
+{
+    if (gRefreshPaused) {
+        gTransferStalled = true;
+        return;
+    }
+    uint8_t byte;
+    if (getNextTransferByte(byte)) {
+        writeHardwareByte(byte);
+    } else {
+        digitalWrite(gChipSelectPin, LOW);
+    }
+}
+
+
+// Start a transfer to the display.
+//
+// With the software interface, the first pixel rows are sent at once.
+// With a hardware interface, only the first byte is sent, all following
+// bytes are sent from the transfer complete interrupt.
+//
+// @param command The command for the transfer.
+// @param allRows If all rows are sent, or only the marked ones.
+// @param invert If all pixels are inverted.
+//
+void startTransfer(uint8_t command, bool allRows, bool invert)
+{
+    gTransferCommand = command;
+    gTransferAllRows = allRows;
+    gTransferInvertMask = (invert ? 0xff : 0x00);
+    gTransferState = TransferCommand;
+    digitalWrite(gChipSelectPin, HIGH);
+    if (gInterface == SharpDisplay::SoftwareInterface) {
+        sendTransferChunk();
+    } else {
+        sendNextTransferByte();
+    }
+}
+
+
+// Check if a transfer is running.
+inline bool isTransferRunning()
+{
+    return gTransferState != TransferIdle;
+}
+
+    
+void refreshDisplay()
+{
+    if (gClearRequested) {
+        gClearRequested = false;
+        startTransfer(CMD_CLEAR, false, false);
+    } else {
+        startTransfer(CMD_WRITE, false, false);
+    }
 }
 
     
 void refreshFullDisplay(bool invert)
 {
-    // Send the write command.
-    digitalWrite(gChipSelectPin, HIGH);
-    sendByteMSB(CMD_WRITE|gVComBit);
-    toggleVComBit();
-    // Update all rows which need a refresh.
-    for (uint8_t row = 0; row < gScreenHeight; ++row) {
-        // Draw the row pixel row by pixel row
-        for (uint8_t pixelRow = 0; pixelRow < gCharacterHeight; ++pixelRow) {
-            sendByteLSB(row*gCharacterHeight+pixelRow+1);
-            for (uint8_t column = 0; column < gScreenWidth; ++column) {
-                const uint8_t screenData = *(getCharacterPosition(row, column));
-                const uint8_t characterIndex = (screenData & gTextCharacterMask);
-                uint16_t characterStart = characterIndex;
-                characterStart *= gCharacterHeight;
-                characterStart += pixelRow;
-                uint8_t pixelMask = pgm_read_byte(gTextFont+characterStart);
-                if ((screenData & gTextFlagInverse) != 0) { // Inverse character?
-                    pixelMask = ~pixelMask;
-                }
-                if (invert) {
-                    pixelMask = ~pixelMask;
-                }
-                sendByteMSB(pixelMask);
-            }
-            sendByteLSB(0x00);
+    gClearRequested = false; // All rows are written.
+    startTransfer(CMD_WRITE, true, invert);
+}
+
+
+    
+// Get the pixel rows which differ between two characters.
+//
+// This compares the rendered pixels, so only the pixel rows which
+// really change on the display are marked for an update.
+//
+inline uint8_t getChangedPixelRows(uint8_t oldScreenData, uint8_t newScreenData)
+{
+    const uint8_t *oldGlyph = gTextFont + (static_cast<uint16_t>(oldScreenData & gTextCharacterMask) * gCharacterHeight);
+    const uint8_t *newGlyph = gTextFont + (static_cast<uint16_t>(newScreenData & gTextCharacterMask) * gCharacterHeight);
+    const uint8_t invertMask = (((oldScreenData ^ newScreenData) & gTextFlagInverse) != 0) ? 0xff : 0x00;
+    uint8_t pixelRowMask = 0;
+    for (uint8_t pixelRow = 0; pixelRow < gCharacterHeight; ++pixelRow) {
+        if ((pgm_read_byte(oldGlyph++) ^ pgm_read_byte(newGlyph++)) != invertMask) {
+            pixelRowMask |= (1<<pixelRow);
         }
     }
-    sendByteLSB(0x00);
-    digitalWrite(gChipSelectPin, LOW);
-    clearScreenUpdate();
+    return pixelRowMask;
 }
 
     
@@ -282,8 +686,8 @@ inline void fastSetCharacter(uint8_t row, uint8_t column, uint8_t character)
     uint8_t* const cp = getCharacterPosition(row, column);
     const uint8_t newChar = ((static_cast<uint8_t>(character)-0x20) & gTextCharacterMask) | gTextFlags;
     if (*cp != newChar) {
+        markPixelRowsForUpdate(row, getChangedPixelRows(*cp, newChar));
         *cp = newChar;
-        markRowForUpdate(row);
     }
 }
 
@@ -356,23 +760,31 @@ inline void fastWriteCharacter(uint8_t c)
 // This interrupt will automatically refresh the display.
 ISR(TIMER2_OVF_vect)
 {
+    // Continue a transfer using the software interface. A transfer
+    // using the hardware interface continues by itself.
+    if (lr::isTransferRunning() && lr::gInterface == lr::SharpDisplay::SoftwareInterface && !lr::gRefreshPaused) {
+        lr::sendTransferChunk();
+    }
+    
     // Check the protect counter, this counter will make sure the
     // whole display is refreshed and inverted every two hours
     // to prevent any stuck pixels.
     bool refreshDone = false;
     ++lr::gDisplayProtectCounter;
+    // No refresh is started while a transfer is running, the screen is changed or the refresh is paused.
+    const bool refreshBlocked = lr::isTransferRunning() || lr::isScreenLocked() || lr::gRefreshPaused;
     if (lr::gDisplayProtectCounter >= (lr::gDisplayProtectTrigger+0x80)) {
         lr::gDisplayProtectCounter = 0;
         lr::markScreenForUpdate();
     } else if (lr::gDisplayProtectCounter >= (lr::gDisplayProtectTrigger+0x40)) {
         // Refresh the whole display, back normal.
-        if ((lr::gDisplayProtectCounter&7) == 0) {
+        if ((lr::gDisplayProtectCounter&7) == 0 && !refreshBlocked) {
             lr::refreshFullDisplay(false);
         }
         refreshDone = true;
     } else if (lr::gDisplayProtectCounter >= lr::gDisplayProtectTrigger) {
         // Refresh the whole display, inverse.
-        if ((lr::gDisplayProtectCounter&7) == 0) {
+        if ((lr::gDisplayProtectCounter&7) == 0 && !refreshBlocked) {
             lr::refreshFullDisplay(true);
         }
         refreshDone = true;
@@ -382,7 +794,7 @@ ISR(TIMER2_OVF_vect)
     ++lr::gDisplayRefreshCounter;
     if (lr::gDisplayRefreshCounter > lr::gDisplayRefreshTrigger) {
         lr::gDisplayRefreshCounter = 0;
-        if (!refreshDone) {
+        if (!refreshDone && !refreshBlocked) {
             lr::refreshDisplay();
         }
     }
@@ -394,12 +806,34 @@ ISR(TIMER2_OVF_vect)
 }
 
 
+// The interrupt if a byte was sent using the hardware SPI.
+ISR(SPI_STC_vect)
+{
+    lr::sendNextTransferByte();
+}
+
+
+// The interrupt if a byte was sent using the USART in SPI mode.
+ISR(USART_TX_vect)
+{
+    lr::sendNextTransferByte();
+}
+
+
 namespace lr {
 namespace SharpDisplay {
 
     
-void begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin)
+bool begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin, Interface interface)
 {
+    // The hardware interfaces only work with their own pins.
+    if (interface == HardwareSpiInterface && (clockPin != gSpiClockPin || dataPin != gSpiDataPin)) {
+        return false;
+    }
+    if (interface == UsartSpiInterface && (clockPin != gUsartClockPin || dataPin != gUsartDataPin || KeyPad::isKeyPin(gUsartClockPin))) {
+        return false;
+    }
+    
     // Prepare the values for the SPI communication
     gChipSelectPin = chipSelectPin;
     gClockPin = clockPin;
@@ -408,6 +842,9 @@ void begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin)
     gDataPin = dataPin;
     gDataPort = portOutputRegister(digitalPinToPort(dataPin));
     gDataMask = digitalPinToBitMask(dataPin);
+    gInterface = interface;
+    gTransferState = TransferIdle;
+    gTransferStalled = false;
     
     // Initialize the screen memory
     clearScreen();
@@ -416,6 +853,9 @@ void begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin)
     gTextFont = gNoFont;
     gCursorX = 0;
     gCursorY = 0;
+    gChartFirstRow = 0;
+    gChartRowCount = 0;
+    clearChartColumns();
     
     // Initialize the counter.
     gDisplayRefreshCounter = 0;
@@ -426,12 +866,25 @@ void begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin)
     gInterruptCallback = nullptr;
 
     // Prepare all communication ports
-    digitalWrite(gChipSelectPin, HIGH);
+    digitalWrite(gChipSelectPin, LOW);
     digitalWrite(gClockPin, LOW);
     digitalWrite(gDataPin, HIGH);
     pinMode(gChipSelectPin, OUTPUT);
     pinMode(gClockPin, OUTPUT);
     pinMode(gDataPin, OUTPUT);
+    if (interface == HardwareSpiInterface) {
+        // The SS pin has to be an output, to keep the SPI in master mode.
+        pinMode(10, OUTPUT);
+        // Master, mode 0, MSB first, 1MHz, interrupt after each byte.
+        SPSR = 0;
+        SPCR = _BV(SPIE)|_BV(SPE)|_BV(MSTR)|_BV(SPR0);
+    } else if (interface == UsartSpiInterface) {
+        // Master SPI mode, mode 0, MSB first, 1MHz, interrupt after each byte.
+        UBRR0 = 0;
+        UCSR0C = _BV(UMSEL01)|_BV(UMSEL00);
+        UCSR0B = _BV(TXEN0)|_BV(TXCIE0);
+        UBRR0 = 7;
+    }
     // Set the VCOM bit
     gVComBit = CMD_VCOM;
     // Clear the display.
@@ -444,6 +897,7 @@ void begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin)
     OCR2B = 0; // Ignore the compare
     TIMSK2 = _BV(TOIE2); // Interrupt on overflow.
     sei(); // Allow interrupts.    
+    return true;
 }
 
     
@@ -459,6 +913,48 @@ void setRefreshInterval(RefreshInterval refreshInterval)
 }
     
     
+void setMaximumPixelRowsPerInterrupt(uint8_t pixelRowCount)
+{
+    LockInterrupt lock;
+    gMaximumPixelRowsPerInterrupt = max(pixelRowCount, static_cast<uint8_t>(1));
+}
+
+
+void setRefreshPaused(bool paused)
+{
+    LockInterrupt lock;
+    gRefreshPaused = paused;
+    if (!paused && gTransferStalled) {
+        gTransferStalled = false;
+        sendNextTransferByte();
+    }
+}
+
+
+void resumeAfterSleep(uint8_t seconds)
+{
+    LockInterrupt lock;
+    gDisplayRefreshCounter = gDisplayRefreshTrigger; // Refresh with the next interrupt.
+    // Skip the sleep time until the full refresh, but run the full refresh
+    // itself with the interrupts.
+    if (gDisplayProtectCounter < gDisplayProtectTrigger) {
+        gDisplayProtectCounter = min(gDisplayProtectCounter + (static_cast<uint32_t>(seconds) * 61), gDisplayProtectTrigger);
+    }
+}
+
+
+bool isRefreshRunning()
+{
+    return isTransferRunning();
+}
+
+
+bool isHardwareTransferRunning()
+{
+    return isTransferRunning() && gInterface != SoftwareInterface;
+}
+
+
 void setInterruptCallback(InterruptCallback interruptCallback)
 {
     gInterruptCallback = interruptCallback;
@@ -467,7 +963,7 @@ void setInterruptCallback(InterruptCallback interruptCallback)
     
 void setFont(const uint8_t *fontData)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     gTextFont = fontData;
     markScreenForUpdate();
 }
@@ -475,13 +971,9 @@ void setFont(const uint8_t *fontData)
     
 void clear()
 {
-    LockInterrupt lock;
-    // Send the clear command.
-    digitalWrite(gChipSelectPin, HIGH);
-    sendByteMSB(CMD_CLEAR|gVComBit);
-    sendByteMSB(0);
-    toggleVComBit();
-    digitalWrite(gChipSelectPin, LOW);
+    LockScreen lock;
+    // The clear command is sent with the next refresh.
+    gClearRequested = true;
 
     // Clear the screen.
     clearScreen();
@@ -493,7 +985,7 @@ void clear()
     
 void clearRows(uint8_t startRow, uint8_t rowCount)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     for (uint8_t y = 0; y < rowCount; ++y) {
         const uint8_t row = startRow+y;
         memset(getCharacterPosition(row, 0), 0, gScreenWidth);
@@ -514,7 +1006,7 @@ void setTextInverse(bool enable)
     
 void setCharacter(uint8_t row, uint8_t column, uint8_t character)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     if (row < gScreenWidth && column < gScreenHeight) {
         fastSetCharacter(row, column, character);
     }
@@ -523,8 +1015,9 @@ void setCharacter(uint8_t row, uint8_t column, uint8_t character)
     
 char getCharacter(uint8_t row, uint8_t column)
 {
-    LockInterrupt lock;
-    if (row < gScreenWidth && column < gScreenHeight) {
+    if (isChartRow(row)) {
+        return ' '; // The text of the chart rows is not shown.
+    } else if (row < gScreenWidth && column < gScreenHeight) {
         const uint8_t* const cp = getCharacterPosition(row, column);
         return (*cp & gTextCharacterMask) + 0x20;
     } else {
@@ -535,7 +1028,7 @@ char getCharacter(uint8_t row, uint8_t column)
     
 void setLineText(uint8_t row, const String &text)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     if (row < gScreenHeight) {
         const uint8_t length = text.length();
         for (uint8_t column = 0; column < gScreenWidth; ++column) {
@@ -545,14 +1038,13 @@ void setLineText(uint8_t row, const String &text)
                 fastSetCharacter(row, column, ' ');
             }
         }
-        markRowForUpdate(row);
     }
 }
 
     
 void setLineText(uint8_t row, const char *prgMemText)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     if (row < gScreenHeight) {
         const uint8_t length = strlen_P(prgMemText);
         for (uint8_t column = 0; column < gScreenWidth; ++column) {
@@ -562,14 +1054,13 @@ void setLineText(uint8_t row, const char *prgMemText)
                 fastSetCharacter(row, column, ' ');
             }
         }
-        markRowForUpdate(row);
     }
 }
     
     
 void fillRow(uint8_t row, char c)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     if (row < gScreenHeight) {
         for (uint8_t column = 0; column < gScreenWidth; ++column) {
             fastSetCharacter(row, column, c);
@@ -580,7 +1071,7 @@ void fillRow(uint8_t row, char c)
     
 void setLineInverted(uint8_t row, bool inverted)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     if (row < gScreenHeight) {
         for (uint8_t column = 0; column < gScreenWidth; ++column) {
             uint8_t *c = getCharacterPosition(row, column);
@@ -622,14 +1113,14 @@ void getCursorPosition(uint8_t &row, uint8_t &column)
     
 void writeCharacter(uint8_t c)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     fastWriteCharacter(c);
 }
 
     
 void writeText(const String &text)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     const unsigned int length = text.length();
     for (unsigned int i = 0; i < length; ++i) {
         fastWriteCharacter(text.charAt(i));
@@ -639,7 +1130,7 @@ void writeText(const String &text)
     
 void writeText(const char *prgMemText)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     char c;
     while ((c = pgm_read_byte(prgMemText++)) != 0) {
         fastWriteCharacter(c);
@@ -649,9 +1140,58 @@ void writeText(const char *prgMemText)
     
 void scrollScreen(ScrollDirection direction)
 {
-    LockInterrupt lock;
+    LockScreen lock;
     fastScrollScreen(direction);
 }
+
+
+void setChartRows(uint8_t firstRow, uint8_t rowCount)
+{
+    LockScreen lock;
+    if (firstRow >= gScreenHeight) {
+        rowCount = 0;
+    } else if (rowCount > (gScreenHeight-firstRow)) {
+        rowCount = gScreenHeight-firstRow;
+    }
+    clearChartColumns(); // The previous rows show empty text again.
+    markChartForUpdate();
+    gChartFirstRow = firstRow;
+    gChartRowCount = rowCount;
+    clearChartColumns();
+    markChartForUpdate();
+}
+
+
+uint8_t getChartWidth()
+{
+    return getChartColumnCount();
+}
+
+
+uint8_t getChartHeight()
+{
+    return gChartRowCount*gCharacterHeight;
+}
+
+
+void clearChart()
+{
+    LockScreen lock;
+    clearChartColumns();
+    markChartForUpdate();
+}
+
+
+void setChartColumn(uint8_t column, uint8_t value)
+{
+    LockScreen lock;
+    if (column < getChartColumnCount()) {
+        // Only the pixel rows of the previous and the new lines change.
+        markChartColumnForUpdate(column);
+        getChartValues()[column] = (value < getChartHeight()) ? (value+1) : 0;
+        markChartColumnForUpdate(column);
+    }
+}
     
 
 }
@@ -57,6 +57,14 @@ enum RefreshInterval : uint8_t {
     SlowRefresh, ///< Refresh every second.
 };
 
+/// The interface used to send data to the display.
+///
+enum Interface : uint8_t {
+    SoftwareInterface, ///< Bit-banging on any two pins, all data is sent from the timer interrupt.
+    HardwareSpiInterface, ///< The SPI hardware, clock on pin 13 and data on pin 11.
+    UsartSpiInterface, ///< The USART in SPI mode, clock on pin 4 and data on pin 1, pin 4 must not be a key.
+};
+
 /// The type for the interrupt callback.
 ///
 typedef void (*InterruptCallback)();
@@ -65,12 +73,76 @@ typedef void (*InterruptCallback)();
 ///
 /// This will start timer2 to automatically trigger the display refresh.
 ///
-void begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin);
+/// Using a hardware interface, the timer interrupt only starts the
+/// refresh. The data is sent with 1MHz, each byte from the transfer
+/// complete interrupt, so other code runs while the data is sent.
+/// The SPI interface sets pin 10 as output. The USART interface
+/// can not be used together with the serial port, and its clock on
+/// pin 4 is the enter key of the default wiring.
+///
+/// @param chipSelectPin The pin for the chip select signal.
+/// @param clockPin The pin for the clock signal, it has to match the interface.
+/// @param dataPin The pin for the data signal, it has to match the interface.
+/// @param interface The interface used to send the data.
+/// @return false if the pins do not match the interface, or the clock
+///    of the USART interface is used by a key. Nothing is initialized
+///    in this case. Initialize the key pad first.
+///
+bool begin(uint8_t chipSelectPin, uint8_t clockPin, uint8_t dataPin, Interface interface = SoftwareInterface);
 
 /// Change the refresh interval
 ///
 void setRefreshInterval(RefreshInterval refreshInterval);
 
+/// Set the maximum number of pixel rows sent in one interrupt.
+///
+/// This limits the time spent in the timer interrupt using the software
+/// interface. A refresh with more pixel rows continues in the following
+/// interrupts, about every 16ms. The default of 16 pixel rows sends the
+/// whole screen in 6 interrupts. Smaller values delay the refresh. The
+/// hardware interfaces are not limited, because they only send one byte
+/// in each interrupt.
+///
+/// @param pixelRowCount The number of pixel rows, at least one.
+///
+void setMaximumPixelRowsPerInterrupt(uint8_t pixelRowCount);
+
+/// Pause the refresh of the display.
+///
+/// While paused, the timer interrupt sends no data to the display and
+/// returns quickly. Use this for code which times signals using
+/// interrupts. The interrupt callback is still called. A transfer
+/// using a hardware interface stops after the current byte, and
+/// continues at the end of the pause.
+///
+void setRefreshPaused(bool paused);
+
+/// Continue the refresh after the timer was stopped.
+///
+/// The timer stops in the power-down sleep mode. Call this after each
+/// wake-up. It starts a refresh with the next interrupt, which also
+/// inverts VCOM of the display, and advances the counter of the
+/// periodic full refresh by the sleep time. The display needs an
+/// inversion of VCOM about every second.
+///
+/// @param seconds The time the timer was stopped.
+///
+void resumeAfterSleep(uint8_t seconds);
+
+/// Check if data is sent to the display.
+///
+/// The power-down sleep mode stops the timer and the hardware interfaces,
+/// so sleep only in this mode if this returns false.
+///
+bool isRefreshRunning();
+
+/// Check if data is sent using a hardware interface.
+///
+/// The hardware interfaces need the I/O clock, which also stops in the
+/// power save sleep mode. Sleep only in idle mode if this returns true.
+///
+bool isHardwareTransferRunning();
+
 /// Set a function which is called for each interrupt.
 ///
 void setInterruptCallback(InterruptCallback interruptCallback);
@@ -129,7 +201,7 @@ void setCharacter(uint8_t row, uint8_t column, uint8_t character);
 ///
 /// @param row The row for the character.
 /// @param column The column for the character.
-/// @return The character the the given position.
+/// @return The character the the given position, a space in the rows of the chart.
 ///
 char getCharacter(uint8_t row, uint8_t column);
 
@@ -214,6 +286,46 @@ void writeText(const char *prgMemText);
 ///
 void scrollScreen(ScrollDirection direction);
 
+/// Set the rows used for the chart.
+///
+/// The chart replaces the text in a range of rows with a graphic,
+/// which is refreshed like the text rows. It covers the whole width
+/// of the display, and up to the whole screen of 96x96 pixels. Each
+/// pixel column of the chart shows a value, which is set using
+/// setChartColumn(). The chart is cleared.
+///
+/// The chart keeps its values in the text of its rows, so the text
+/// of these rows must not be changed while the chart is shown. With
+/// less than 8 rows, the chart is narrower than the screen.
+///
+/// @param firstRow The first row of the chart.
+/// @param rowCount The number of rows, 0 to disable the chart.
+///
+void setChartRows(uint8_t firstRow, uint8_t rowCount);
+
+/// Get the width of the chart in pixels.
+///
+uint8_t getChartWidth();
+
+/// Get the height of the chart in pixels.
+///
+uint8_t getChartHeight();
+
+/// Clear all columns of the chart.
+///
+void clearChart();
+
+/// Set the value in a pixel column of the chart.
+///
+/// The column shows a line from the value of the previous column to
+/// this value, or a single pixel if the previous column is empty.
+///
+/// @param column The pixel column, 0 is left.
+/// @param value The pixel row of the value, 0 is the top of the chart.
+///    A value outside of the chart height empties the column.
+///
+void setChartColumn(uint8_t column, uint8_t value);
+
 
 }
 }
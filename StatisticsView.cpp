@@ -0,0 +1,171 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "StatisticsView.h"
+
+
+#include "Application.h"
+#include "LogSystem.h"
+#include "SharpDisplay.h"
+#include "ViewManager.h"
+
+
+namespace lr {
+namespace StatisticsView {
+
+
+// The pages of the view.
+enum Page : uint8_t {
+    AllTemperature,
+    AllHumidity,
+    DayTemperature,
+    DayHumidity,
+    WeekTemperature,
+    WeekHumidity,
+    YearTemperature,
+    YearHumidity,
+    PageCount
+};
+
+
+static Page gPage = AllTemperature; ///< The current page.
+
+
+// The number of seconds per day.
+static const uint32_t cSecondsPerDay = 86400;
+
+
+void viewWillAppear()
+{
+    Application::setOperationMode(Application::FullScreenMode);
+}
+
+
+// Display a value with a label in a row.
+void setValueLine(uint8_t row, const String &label, float value)
+{
+    String text = label;
+    if (isnan(value)) {
+        text += F("-");
+    } else {
+        text += String(value, 1);
+    }
+    SharpDisplay::setLineText(row, text);
+}
+
+
+// Get the summary of the last 7 days or the last 52 weeks.
+//
+// The ranges start at midnight or on monday, so the log can combine
+// them from its daily and weekly rollups.
+//
+LogSystem::Summary getSummary(bool isYear)
+{
+    const uint32_t recordCount = LogSystem::currentNumberOfRecords();
+    if (recordCount == 0) {
+        return LogSystem::getSummary(DateTime(), DateTime());
+    }
+    const uint32_t newestTime = LogSystem::getLogRecord(recordCount - 1).getDateTime().toSecondsSince2000();
+    const uint32_t day = newestTime / cSecondsPerDay;
+    uint32_t firstDay;
+    if (isYear) {
+        // 2000-01-01 was a saturday.
+        firstDay = day - ((day + 5) % 7) - (51 * 7);
+    } else {
+        firstDay = day - 6;
+    }
+    return LogSystem::getSummary(DateTime::fromSecondsSince2000(firstDay * cSecondsPerDay), DateTime::fromSecondsSince2000(newestTime + 1));
+}
+
+
+void updateDisplay()
+{
+    const bool isSummary = (gPage >= WeekTemperature);
+    const bool isTemperature = ((gPage % 2) == 0);
+    LogSystem::Statistics statistics;
+    bool isComplete = true;
+    if (isSummary) {
+        // The summary is combined from the rollups of the log.
+        const LogSystem::Summary summary = getSummary(gPage >= YearTemperature);
+        statistics.numberOfRecords = summary.numberOfRecords;
+        statistics.temperature = summary.temperature;
+        statistics.humidity = summary.humidity;
+        isComplete = summary.complete;
+    } else {
+        // The statistics are kept by the log system, this reads no records.
+        statistics = LogSystem::getStatistics((gPage >= DayTemperature) ? LogSystem::LastDay : LogSystem::AllRecords);
+    }
+    const LogSystem::ValueStatistics &values = isTemperature ? statistics.temperature : statistics.humidity;
+    SharpDisplay::setTextInverse(false);
+    if (isTemperature) {
+        SharpDisplay::setLineText(0, PSTR("Temp. \x7f""C"));
+    } else {
+        SharpDisplay::setLineText(0, PSTR("Humidity %"));
+    }
+    SharpDisplay::fillRow(1, '\x89');
+    SharpDisplay::setLineText(2, String(F("N: ")) + String(values.count, DEC));
+    setValueLine(3, String(F("Min: ")), values.minimum);
+    setValueLine(4, String(F("Max: ")), values.maximum);
+    setValueLine(5, String(F("Mean: ")), values.mean);
+    setValueLine(6, String(F("SD: ")), values.standardDeviation);
+    SharpDisplay::fillRow(7, ' ');
+    if (isComplete) {
+        SharpDisplay::fillRow(8, ' ');
+    } else {
+        SharpDisplay::setLineText(8, PSTR("Incomplete"));
+    }
+    SharpDisplay::fillRow(9, '\x89');
+    if (gPage >= YearTemperature) {
+        SharpDisplay::setLineText(10, PSTR("52 Weeks"));
+    } else if (gPage >= WeekTemperature) {
+        SharpDisplay::setLineText(10, PSTR("Last 7 Days"));
+    } else if (gPage >= DayTemperature) {
+        SharpDisplay::setLineText(10, PSTR("Last 24h"));
+    } else {
+        SharpDisplay::setLineText(10, PSTR("All Records"));
+    }
+    SharpDisplay::setLineText(11, String(F("R: ")) + String(statistics.numberOfRecords, DEC));
+}
+
+
+void handleKey(KeyPad::Key key)
+{
+    switch (key) {
+        case KeyPad::Up:
+            gPage = static_cast<Page>((gPage > 0) ? (gPage - 1) : (PageCount - 1));
+            break;
+            
+        case KeyPad::Down:
+        case KeyPad::Right:
+            gPage = static_cast<Page>((gPage + 1) % PageCount);
+            break;
+            
+        case KeyPad::Left:
+            ViewManager::setNextView(ViewManager::MainMenuView);
+            return;
+            
+        default:
+            break;
+    }
+    ViewManager::setNeedsDisplayUpdate();
+}
+
+
+}
+}
@@ -20,90 +20,121 @@
 #include "Storage.h"
 
 
-#include <Wire.h>
+#include "FramStorage.h"
 
 
 namespace lr {
 namespace Storage {
 
 
-/// The address of the FRAM chip in the I2C bus.
-///
-/// The address is 1010AAA where AAA is the custom address which can
-/// be set with the pins on the chip.
-///
-static const uint8_t cMb85RcAddress = B1010000;
+static const Backend *gBackend = nullptr; ///< The selected backend.
+static uint32_t gSequentialIndex; ///< The next index for backends without sequential read.
+
+
+void setBackend(const Backend *backend)
+{
+    gBackend = backend;
+}
 
 
 bool begin()
 {
-    // Read the manufacturer ID and product ID to make sure the FRAM is available.
-    Wire.beginTransmission(0xf8>>1);
-    Wire.write(cMb85RcAddress<<1);
-    Wire.endTransmission(false);
-    Wire.requestFrom(0xf8>>1, 3);
-    const uint8_t id0 = Wire.read();
-    const uint8_t id1 = Wire.read();
-    const uint8_t id2 = Wire.read();
-    const uint16_t manufacturerID = (id0<<4)+(id1>>4);
-    const uint16_t productID = ((id1&0x0f)<<8)+id2;
-    // Check the both IDs
-    if (manufacturerID != 0x00a || productID != 0x510) {
-        return false;
+    if (gBackend == nullptr) {
+        gBackend = FramStorage::getBackend();
     }
-    return true;
+    gSequentialIndex = 0;
+    return gBackend->begin();
 }
 
 
 uint32_t size()
 {
-    return 32768; // 32KB
+    return gBackend->size();
+}
+
+
+bool hasLimitedEndurance()
+{
+    return gBackend->limitedEndurance;
+}
+
+
+uint8_t readByte(uint32_t index)
+{
+    uint8_t data;
+    gBackend->readBytes(index, &data, 1);
+    return data;
+}
+
+
+void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size)
+{
+    gBackend->readBytes(firstIndex, data, size);
+}
+
+
+void beginSequentialRead(uint32_t firstIndex)
+{
+    if (gBackend->beginSequentialRead != nullptr) {
+        gBackend->beginSequentialRead(firstIndex);
+    } else {
+        gSequentialIndex = firstIndex;
+    }
+}
+
+
+uint8_t readNextByte()
+{
+    uint8_t data;
+    readNextBytes(&data, 1);
+    return data;
+}
+
+
+void readNextBytes(uint8_t *data, uint32_t size)
+{
+    if (gBackend->readNextBytes != nullptr) {
+        gBackend->readNextBytes(data, size);
+    } else {
+        gBackend->readBytes(gSequentialIndex, data, size);
+        gSequentialIndex += size;
+    }
 }
 
 
 void writeByte(uint32_t index, uint8_t data)
 {
-    Wire.beginTransmission(cMb85RcAddress);
-    Wire.write(index>>8);
-    Wire.write(index&0xff);
-    Wire.write(data);
-    Wire.endTransmission();
+    gBackend->writeBytes(index, &data, 1);
 }
 
 
 void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size)
 {
-    Wire.beginTransmission(cMb85RcAddress);
-    Wire.write(static_cast<uint8_t>(firstIndex>>8));
-    Wire.write(static_cast<uint8_t>(firstIndex&0xff));
-    for (uint32_t i = 0; i < size; ++i) {
-        Wire.write(data[i]);
+    gBackend->writeBytes(firstIndex, data, size);
+}
+
+
+void writeBytesAsync(uint32_t firstIndex, const uint8_t *data, uint32_t size, TwiMaster::Transfer *transfer)
+{
+    if (gBackend->writeBytesAsync != nullptr) {
+        gBackend->writeBytesAsync(firstIndex, data, size, transfer);
+    } else {
+        gBackend->writeBytes(firstIndex, data, size);
+        transfer->status = TwiMaster::Done;
     }
-    Wire.endTransmission();
 }
 
 
-uint8_t readByte(uint32_t index)
+void waitForWrite(const TwiMaster::Transfer *transfer)
 {
-    Wire.beginTransmission(cMb85RcAddress);
-    Wire.write(static_cast<uint8_t>(index>>8));
-    Wire.write(static_cast<uint8_t>(index&0xff));
-    Wire.endTransmission();
-    Wire.requestFrom(cMb85RcAddress, static_cast<uint8_t>(1));
-    return Wire.read();
+    TwiMaster::waitFor(transfer);
 }
 
 
-void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size)
+void flush()
 {
-    // reads >0xff will not work.
-    Wire.beginTransmission(cMb85RcAddress);
-    Wire.write(static_cast<uint8_t>(firstIndex>>8));
-    Wire.write(static_cast<uint8_t>(firstIndex&0xff));
-    Wire.endTransmission();
-    Wire.requestFrom(cMb85RcAddress, static_cast<uint8_t>(size));
-    for (uint32_t i = 0; i < size; ++i) {
-        data[i] = Wire.read();
+    if (gBackend->flush != nullptr) {
+        gBackend->flush();
     }
 }
 
@@ -112,4 +143,3 @@ void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size)
 }
 
 
-
@@ -20,6 +20,8 @@
 //
 
 
+#include "TwiMaster.h"
+
 #include <Arduino.h>
 
 
@@ -30,11 +32,45 @@ namespace lr {
 ///
 /// This storage class provide a simple abstraction to the hardware layer.
 /// The software can use either the EEPROM to any attached memory to
-/// store the data.
+/// store the data. The memory is accessed using a backend, which is
+/// selected before the storage is initialized.
 ///
 namespace Storage {
     
 
+/// The functions of a storage backend.
+///
+/// The functions have the same meaning as the functions of the storage.
+/// If a backend has no own sequential read, set both functions
+/// for it to nullptr, the storage uses readBytes() instead. If the
+/// backend writes all bytes immediately, set flush to nullptr. If
+/// the backend can not write in the background, set writeBytesAsync
+/// to nullptr, the storage uses writeBytes() instead. Set
+/// limitedEndurance for memory which wears out if the same bytes
+/// are written very often.
+///
+struct Backend {
+    bool (*begin)(); ///< Initialize the backend.
+    uint32_t (*size)(); ///< Get the size of the memory.
+    void (*readBytes)(uint32_t firstIndex, uint8_t *data, uint32_t size); ///< Read multiple bytes.
+    void (*beginSequentialRead)(uint32_t firstIndex); ///< Start a sequential read, or nullptr.
+    void (*readNextBytes)(uint8_t *data, uint32_t size); ///< Read the next bytes, or nullptr.
+    void (*writeBytes)(uint32_t firstIndex, const uint8_t *data, uint32_t size); ///< Write multiple bytes.
+    void (*writeBytesAsync)(uint32_t firstIndex, const uint8_t *data, uint32_t size, TwiMaster::Transfer *transfer); ///< Write multiple bytes in the background, or nullptr.
+    void (*flush)(); ///< Write all cached bytes, or nullptr.
+    bool limitedEndurance; ///< If the memory supports only a limited number of writes.
+};
+
+
+/// Select the backend for the storage.
+///
+/// This has to be called before begin(). If no backend is
+/// selected, the storage uses the FRAM backend.
+///
+/// @param backend The backend, which has to stay valid.
+///
+void setBackend(const Backend *backend);
+
 /// Initialize the storage.
 ///
 /// @return true on success, false if the storage could not be initialized.
@@ -46,6 +82,13 @@ bool begin();
 ///
 uint32_t size();
 
+/// Check if the memory supports only a limited number of writes.
+///
+/// Data which changes with every record should not be written
+/// to the same location of such a memory.
+///
+bool hasLimitedEndurance();
+
 /// Read a byte from this memory.
 ///
 uint8_t readByte(uint32_t index);
@@ -58,18 +101,71 @@ uint8_t readByte(uint32_t index);
 ///
 void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size);
 
+/// Start a sequential read at the given index.
+///
+/// The following calls to readNextByte() and readNextBytes() read
+/// the memory in sequence. Sequential reads are not affected by
+/// other reads.
+///
+/// @param firstIndex The index for the first byte.
+///
+void beginSequentialRead(uint32_t firstIndex);
+
+/// Read the next byte of the sequential read.
+///
+uint8_t readNextByte();
+
+/// Read the next bytes of the sequential read.
+///
+/// @param data A pointer to the target buffer.
+/// @param size The number of bytes to read into the target buffer.
+///
+void readNextBytes(uint8_t *data, uint32_t size);
+
 /// Write a byte to this memory.
 ///
 void writeByte(uint32_t index, uint8_t data);
 
 /// Write multiple bytes to this memory.
 ///
+/// Depending on the backend, the bytes are gathered in a write cache
+/// until the next read or the next call to flush().
+///
 /// @param startIndex The index for the first byte.
 /// @param data A pointer to the data to write into memory.
 /// @param size The number of bytes to write to the memory.
 ///
 void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size);
 
+/// Write multiple bytes to this memory in the background.
+///
+/// The bytes are written after all previous writes. If the backend
+/// can not write in the background, the bytes are written immediately
+/// and the transfer is marked as done.
+///
+/// @param firstIndex The index for the first byte.
+/// @param data A pointer to the data, which has to stay unchanged
+///   until the transfer is finished.
+/// @param size The number of bytes to write to the memory.
+/// @param transfer The transfer descriptor to use, which has to stay
+///   valid until the transfer is finished.
+///
+void writeBytesAsync(uint32_t firstIndex, const uint8_t *data, uint32_t size, TwiMaster::Transfer *transfer);
+
+/// Wait until a write in the background is finished.
+///
+/// @param transfer The transfer passed to writeBytesAsync(). It has to
+///   be initialized with the status TwiMaster::Done before first use.
+///
+void waitForWrite(const TwiMaster::Transfer *transfer);
+
+/// Write all bytes from the write cache to the memory.
+///
+/// The bytes may be written in the background, use
+/// TwiMaster::waitUntilIdle() to wait until they are written.
+///
+void flush();
+
 
 }
 }
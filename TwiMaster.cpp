@@ -0,0 +1,276 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "TwiMaster.h"
+
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+
+namespace lr {
+namespace TwiMaster {
+
+
+// The status codes of the TWI hardware in master mode.
+static const uint8_t cStatusStart = 0x08;
+static const uint8_t cStatusRepeatedStart = 0x10;
+static const uint8_t cStatusAddressWriteAck = 0x18;
+static const uint8_t cStatusDataWriteAck = 0x28;
+static const uint8_t cStatusAddressReadAck = 0x40;
+static const uint8_t cStatusDataReadAck = 0x50;
+static const uint8_t cStatusDataReadNack = 0x58;
+
+// The control register values to continue the current transfer.
+static const uint8_t cControlContinue = _BV(TWINT)|_BV(TWEN)|_BV(TWIE);
+
+// The maximum number of devices with their own clock.
+static const uint8_t cMaximumDeviceClocks = 4;
+
+
+/// The bus clock for a single device.
+///
+struct DeviceClock {
+    uint8_t address; ///< The 7-bit address of the device.
+    uint8_t addressMask; ///< The bits of the address to compare.
+    uint8_t bitRate; ///< The value for the bit rate register.
+};
+
+
+static Transfer * volatile gFirstTransfer = nullptr; ///< The current transfer, first in the queue.
+static Transfer *gLastTransfer = nullptr; ///< The last transfer in the queue.
+static uint16_t gByteIndex; ///< The index of the next byte in the current phase.
+static bool gReadPhase; ///< If the data of the current transfer is read.
+static uint8_t gDefaultBitRate; ///< The bit rate register value for all other devices.
+static DeviceClock gDeviceClocks[cMaximumDeviceClocks]; ///< The devices with their own clock.
+static uint8_t gDeviceClockCount = 0; ///< The number of devices with their own clock.
+
+
+/// Get the bit rate register value for a clock.
+///
+/// The prescaler is always 1, which allows clocks from 31kHz
+/// up to 1MHz at 16MHz.
+///
+inline uint8_t getBitRate(uint32_t clock)
+{
+    const uint32_t cyclesPerBit = F_CPU / clock;
+    if (cyclesPerBit <= 16) {
+        return 0;
+    } else if (cyclesPerBit >= (16 + (2 * 255))) {
+        return 255;
+    }
+    return static_cast<uint8_t>((cyclesPerBit - 16) / 2);
+}
+
+
+/// Start the first transfer in the queue.
+///
+inline void startTransfer()
+{
+    const Transfer *transfer = gFirstTransfer;
+    // Switch to the clock of the device, the bit rate can be
+    // changed between two transactions.
+    uint8_t bitRate = gDefaultBitRate;
+    for (uint8_t i = 0; i < gDeviceClockCount; ++i) {
+        if ((transfer->address & gDeviceClocks[i].addressMask) == gDeviceClocks[i].address) {
+            bitRate = gDeviceClocks[i].bitRate;
+            break;
+        }
+    }
+    TWBR = bitRate;
+    gByteIndex = 0;
+    gReadPhase = (transfer->commandSize == 0 && transfer->readData != nullptr);
+    TWCR = cControlContinue|_BV(TWSTA);
+}
+
+
+/// Finish the current transfer and start the next one.
+///
+void finishTransfer(Status status)
+{
+    // Send the stop condition and wait until it was sent.
+    TWCR = _BV(TWINT)|_BV(TWEN)|_BV(TWSTO);
+    while ((TWCR & _BV(TWSTO)) != 0) {
+    }
+    // Remove the transfer from the queue, before calling the callback,
+    // because the callback can add new transfers to the queue.
+    Transfer *transfer = gFirstTransfer;
+    gFirstTransfer = transfer->next;
+    if (gFirstTransfer == nullptr) {
+        gLastTransfer = nullptr;
+    } else {
+        startTransfer();
+    }
+    transfer->status = status;
+    if (transfer->callback != nullptr) {
+        transfer->callback(transfer);
+    }
+}
+
+
+void begin(uint32_t clock)
+{
+    TWSR = 0; // Prescaler 1.
+    gDefaultBitRate = getBitRate(clock);
+    TWBR = gDefaultBitRate;
+    TWCR = _BV(TWEN);
+}
+
+
+void setDeviceClock(uint8_t address, uint32_t clock, uint8_t addressMask)
+{
+    const uint8_t bitRate = getBitRate(clock);
+    address &= addressMask;
+    for (uint8_t i = 0; i < gDeviceClockCount; ++i) {
+        if (gDeviceClocks[i].address == address && gDeviceClocks[i].addressMask == addressMask) {
+            gDeviceClocks[i].bitRate = bitRate;
+            return;
+        }
+    }
+    if (gDeviceClockCount < cMaximumDeviceClocks) {
+        gDeviceClocks[gDeviceClockCount].address = address;
+        gDeviceClocks[gDeviceClockCount].addressMask = addressMask;
+        gDeviceClocks[gDeviceClockCount].bitRate = bitRate;
+        ++gDeviceClockCount;
+    }
+}
+
+
+void queue(Transfer *transfer)
+{
+    transfer->status = Queued;
+    transfer->next = nullptr;
+    const uint8_t oldSREG = SREG;
+    cli();
+    if (gFirstTransfer == nullptr) {
+        gFirstTransfer = transfer;
+        gLastTransfer = transfer;
+        startTransfer();
+    } else {
+        gLastTransfer->next = transfer;
+        gLastTransfer = transfer;
+    }
+    SREG = oldSREG;
+}
+
+
+bool isIdle()
+{
+    return gFirstTransfer == nullptr;
+}
+
+
+void waitFor(const Transfer *transfer)
+{
+    // Interrupts are disabled between the check and the sleep instruction,
+    // so the end of the transfer can not be missed.
+    cli();
+    while (transfer->status == Queued) {
+        SMCR = _BV(SE); // Idle mode, the TWI hardware keeps running.
+        sei();
+        sleep_cpu();
+        cli();
+    }
+    SMCR = 0;
+    sei();
+}
+
+
+void waitUntilIdle()
+{
+    cli();
+    while (gFirstTransfer != nullptr) {
+        SMCR = _BV(SE); // Idle mode, the TWI hardware keeps running.
+        sei();
+        sleep_cpu();
+        cli();
+    }
+    SMCR = 0;
+    sei();
+}
+
+
+bool execute(Transfer *transfer)
+{
+    queue(transfer);
+    waitFor(transfer);
+    return transfer->status == Done;
+}
+
+
+}
+}
+
+
+ISR(TWI_vect)
+{
+    using namespace lr::TwiMaster;
+    Transfer *transfer = gFirstTransfer;
+    switch (TWSR & 0xf8) {
+    case cStatusStart:
+    case cStatusRepeatedStart:
+        TWDR = (transfer->address << 1) | (gReadPhase ? 1 : 0);
+        TWCR = cControlContinue;
+        break;
+        
+    case cStatusAddressWriteAck:
+    case cStatusDataWriteAck:
+        if (gByteIndex < transfer->commandSize) {
+            TWDR = transfer->command[gByteIndex];
+            ++gByteIndex;
+            TWCR = cControlContinue;
+        } else if (transfer->writeData != nullptr && (gByteIndex - transfer->commandSize) < transfer->dataSize) {
+            TWDR = transfer->writeData[gByteIndex - transfer->commandSize];
+            ++gByteIndex;
+            TWCR = cControlContinue;
+        } else if (transfer->readData != nullptr && transfer->dataSize > 0) {
+            // Send a repeated start to read the data.
+            gReadPhase = true;
+            gByteIndex = 0;
+            TWCR = cControlContinue|_BV(TWSTA);
+        } else {
+            finishTransfer(Done);
+        }
+        break;
+        
+    case cStatusAddressReadAck:
+        // Acknowledge all bytes except the last one.
+        TWCR = cControlContinue|(transfer->dataSize > 1 ? _BV(TWEA) : 0);
+        break;
+        
+    case cStatusDataReadAck:
+    case cStatusDataReadNack:
+        transfer->readData[gByteIndex] = TWDR;
+        ++gByteIndex;
+        if (gByteIndex < transfer->dataSize) {
+            TWCR = cControlContinue|((gByteIndex+1) < transfer->dataSize ? _BV(TWEA) : 0);
+        } else {
+            finishTransfer(Done);
+        }
+        break;
+        
+    default:
+        // Missing acknowledge, lost arbitration or bus error.
+        finishTransfer(Failed);
+        break;
+    }
+}
+
+
@@ -0,0 +1,133 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include <Arduino.h>
+
+
+namespace lr {
+
+
+/// An interrupt driven driver for the TWI (I2C) hardware in master mode.
+///
+/// All transfers are described by a transfer descriptor and added to a
+/// queue. The transfers are processed in the order of the queue by the
+/// TWI interrupt, while the CPU can continue with other tasks or sleep
+/// in idle mode.
+///
+namespace TwiMaster {
+
+
+/// The status of a transfer.
+///
+enum Status : uint8_t {
+    Queued, ///< The transfer is in the queue or in progress.
+    Done, ///< The transfer was successful.
+    Failed ///< The device did not acknowledge or the bus failed.
+};
+
+struct Transfer;
+
+/// The function called at the end of a transfer.
+///
+/// This function is called from the TWI interrupt, it has to be short.
+///
+typedef void (*Callback)(Transfer *transfer);
+
+/// The descriptor of a transfer.
+///
+/// A transfer sends the command bytes to the device, e.g. a register or
+/// memory address. For a write transfer, the data follows the command in
+/// the same transaction. For a read transfer, the data is read after a
+/// repeated start. If there are no command bytes, the data is read or
+/// written directly after the start condition.
+///
+/// The descriptor and the data have to stay valid until the transfer
+/// is finished.
+///
+struct Transfer {
+    uint8_t address; ///< The 7-bit address of the device.
+    uint8_t command[2]; ///< The command bytes.
+    uint8_t commandSize; ///< The number of command bytes.
+    const uint8_t *writeData; ///< The data to write, or nullptr.
+    uint8_t *readData; ///< The buffer for the read data, or nullptr.
+    uint16_t dataSize; ///< The number of bytes to write or read.
+    Callback callback; ///< The function to call at the end, or nullptr.
+    volatile Status status; ///< The status of the transfer.
+    Transfer *next; ///< The next transfer in the queue.
+};
+
+
+/// Initialize the TWI hardware.
+///
+/// @param clock The default clock of the bus in Hz.
+///
+void begin(uint32_t clock = 100000);
+
+/// Set the bus clock for a device or a group of devices.
+///
+/// All transfers to this device use the given clock, all other
+/// devices use the default clock. Up to four devices or groups
+/// can have their own clock.
+///
+/// @param address The 7-bit address of the device.
+/// @param clock The clock in Hz, from 31kHz to 1MHz.
+/// @param addressMask The bits of the address to compare, to set the
+///   clock for a group of devices, e.g. 0x78 for 1010AAA.
+///
+void setDeviceClock(uint8_t address, uint32_t clock, uint8_t addressMask = 0x7f);
+
+/// Add a transfer to the queue.
+///
+/// The transfer starts immediately if the bus is idle. This function
+/// can be called from the callback of another transfer.
+///
+void queue(Transfer *transfer);
+
+/// Check if all transfers are finished.
+///
+bool isIdle();
+
+/// Wait until a transfer is finished.
+///
+/// The CPU sleeps in idle mode while waiting.
+/// This must not be called with disabled interrupts.
+///
+void waitFor(const Transfer *transfer);
+
+/// Wait until all transfers are finished.
+///
+/// The CPU sleeps in idle mode while waiting.
+/// This must not be called with disabled interrupts.
+///
+void waitUntilIdle();
+
+/// Add a transfer to the queue and wait until it is finished.
+///
+/// @return true on success, false if the transfer failed.
+///
+bool execute(Transfer *transfer);
+
+
+}
+}
+
+
@@ -21,14 +21,17 @@
 
 
 #include "AdjustTimeView.h"
+#include "ChartView.h"
 #include "EraseAllView.h"
 #include "KeyPad.h"
+#include "LogModeView.h"
 #include "MainMenuView.h"
 #include "MemoryFullView.h"
 #include "RecordView.h"
 #include "SendRecordView.h"
 #include "SetIntervalView.h"
 #include "SharpDisplay.h"
+#include "StatisticsView.h"
 #include "VersionInfoView.h"
 #include "ViewRecordView.h"
 
@@ -158,8 +161,21 @@ void setView(ViewIdentifier view)
             ViewRecordView::viewWillAppear();
             break;
             
+        case StatisticsView:
+            gUpdateDisplayFn = &StatisticsView::updateDisplay;
+            gHandleKeyFn = &StatisticsView::handleKey;
+            StatisticsView::viewWillAppear();
+            break;
+            
+        case ChartView:
+            gUpdateDisplayFn = &ChartView::updateDisplay;
+            gHandleKeyFn = &ChartView::handleKey;
+            ChartView::viewWillAppear();
+            break;
+            
         case SendRecordView:
             gUpdateDisplayFn = &SendRecordView::updateDisplay;
+            gHandleKeyFn = &SendRecordView::handleKey;
             gHandleLoopFn = &SendRecordView::handleLoop;
             SendRecordView::viewWillAppear();
             break;
@@ -176,6 +192,12 @@ void setView(ViewIdentifier view)
             SetIntervalView::viewWillAppear();
             break;
             
+        case LogModeView:
+            gUpdateDisplayFn = &LogModeView::updateDisplay;
+            gHandleKeyFn = &LogModeView::handleKey;
+            LogModeView::viewWillAppear();
+            break;
+            
         case AdjustTimeView:
             gUpdateDisplayFn = &AdjustTimeView::updateDisplay;
             gHandleKeyFn = &AdjustTimeView::handleKey;
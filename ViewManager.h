@@ -40,8 +40,11 @@ enum ViewIdentifier : int8_t {
     RecordView,
     MemoryFullView,
     ViewRecordView,
+    StatisticsView,
+    ChartView,
     SendRecordView,
     SetIntervalView,
+    LogModeView,
     EraseAllView,
     AdjustTimeView,
     VersionInfoView
@@ -34,7 +34,8 @@ namespace ViewRecordView {
 enum ScrollSpeed : uint8_t {
     Speed1,
     Speed10,
-    Speed100
+    Speed100,
+    SpeedDay
 };
 
 
@@ -44,6 +45,28 @@ static uint8_t gCursorPosition = 0; ///< The position of the cursor.
 static ScrollSpeed gScrollSpeed = Speed1; ///< The current scroll speed.
 
 
+// Move the top record by a number of days.
+//
+// The record is found with a binary search over the log, so this
+// does not read all records in between.
+//
+void moveTopRecordByDays(int32_t days)
+{
+    if (gNumberOfRecords == 0) {
+        return;
+    }
+    const DateTime dateTime = LogSystem::getLogRecord(gTopRecord).getDateTime().addDays(days);
+    uint32_t index = LogSystem::findFirstRecordAtOrAfter(dateTime);
+    if (days < 0 && index >= gTopRecord && gTopRecord > 0) {
+        index = gTopRecord - 1; // There are no records in the day before.
+    }
+    if ((index+3) > gNumberOfRecords) {
+        index = (gNumberOfRecords > 3) ? (gNumberOfRecords-3) : 0;
+    }
+    gTopRecord = index;
+}
+
+
 void viewWillAppear()
 {
     Application::setOperationMode(Application::FullScreenMode);
@@ -83,6 +106,7 @@ void updateDisplay()
         case Speed1: recText += F("\x81"); break;
         case Speed10: recText += F("\x81\x81"); break;
         case Speed100: recText += F("\x81\x81\x81"); break;
+        case SpeedDay: recText += F("Day"); break;
     }
     SharpDisplay::setLineText(10, recText);
     String position = String(gTopRecord+gCursorPosition+1, DEC);
@@ -114,6 +138,8 @@ void handleKey(KeyPad::Key key)
                 } else {
                     gTopRecord = 0;
                 }
+            } else if (gScrollSpeed == SpeedDay) {
+                moveTopRecordByDays(-1);
             }
             break;
             
@@ -138,6 +164,8 @@ void handleKey(KeyPad::Key key)
                         gTopRecord = gNumberOfRecords-3;
                     }
                 }
+            } else if (gScrollSpeed == SpeedDay) {
+                moveTopRecordByDays(1);
             }
             break;
             
@@ -145,7 +173,8 @@ void handleKey(KeyPad::Key key)
             switch (gScrollSpeed) {
                 case Speed1: gScrollSpeed = Speed10; break;
                 case Speed10: gScrollSpeed = Speed100; break;
-                case Speed100: gScrollSpeed = Speed1; break;
+                case Speed100: gScrollSpeed = SpeedDay; break;
+                case SpeedDay: gScrollSpeed = Speed1; break;
             }
             break;
             
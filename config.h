@@ -23,3 +23,33 @@
 // The current application version.
 #define APP_VERSION "1.0b"
 
+
+// The pins of the DHT22 sensors, one for each channel.
+#define SENSOR_PINS 3
+
+// The number of sensor channels, matching the number of pins above (1-8).
+// Each record stores the values of all channels with one shared time.
+#define SENSOR_CHANNEL_COUNT 1
+
+
+// The interface used to send the data to the display, one of:
+// - SoftwareInterface: Chip select on pin 11, clock on pin 9 and data on pin 10.
+// - HardwareSpiInterface: Needs a rewiring of the display, chip select to pin 10,
+//   clock to pin 13 (SCK) and data to pin 11 (MOSI).
+// - UsartSpiInterface: Needs a rewiring of the display, chip select to pin 10,
+//   clock to pin 4 (XCK) and data to pin 1 (TXD). The enter key has to move from
+//   pin 4 to a free pin, see KEY_ENTER_PIN. Records can not be sent to the serial
+//   port, because it uses the same pins.
+// The hardware interfaces send the data in the background, instead of the timer interrupt.
+#define DISPLAY_INTERFACE SoftwareInterface
+
+// The pin of the enter key. Use pin 7 with the USART interface of the display.
+#define KEY_ENTER_PIN 4
+
+
+// If the alarm of the real time clock wakes the microcontroller in the power
+// saving modes (1) or timer 2 of the display (0). The alarm needs a wire from
+// the INT/SQW output of the DS3231 to pin 2 (INT0), and lets it sleep in the
+// power-down mode between the seconds. Without this wire, use 0: It wakes
+// about 61 times a second from the power save mode, and uses more power.
+#define RTC_ALARM_WAKEUP 1
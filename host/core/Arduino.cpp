@@ -0,0 +1,296 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+
+#include "../sim/Simulator.h"
+
+
+// The simulated registers.
+StatusRegister SREG;
+volatile uint8_t SMCR;
+volatile uint8_t EICRA;
+volatile uint8_t EIMSK;
+volatile uint8_t EIFR;
+volatile uint8_t PCICR;
+volatile uint8_t PCIFR;
+volatile uint8_t PCMSK0;
+volatile uint8_t PCMSK1;
+volatile uint8_t PCMSK2;
+volatile uint8_t TCCR2A;
+volatile uint8_t TCCR2B;
+Timer2CounterRegister TCNT2;
+volatile uint8_t OCR2A;
+volatile uint8_t OCR2B;
+volatile uint8_t TIMSK2;
+volatile uint8_t ASSR;
+
+
+// The number of digital pins of the ATmega328P.
+static const uint8_t cPinCount = 20;
+
+// The port registers for port B, C and D.
+static volatile uint8_t gPortOutput[3];
+static volatile uint8_t gPortInput[3];
+static volatile uint8_t gPortMode[3];
+
+
+/// Get the index of a port in the register arrays.
+///
+static inline uint8_t getPortIndex(uint8_t port)
+{
+    return port - PB;
+}
+
+
+// Default interrupt vectors, if the firmware does not define them.
+extern "C" __attribute__((weak)) void INT0_vect(void)
+{
+}
+
+extern "C" __attribute__((weak)) void PCINT0_vect(void)
+{
+}
+
+extern "C" __attribute__((weak)) void PCINT1_vect(void)
+{
+}
+
+extern "C" __attribute__((weak)) void PCINT2_vect(void)
+{
+}
+
+extern "C" __attribute__((weak)) void TIMER2_OVF_vect(void)
+{
+}
+
+extern "C" __attribute__((weak)) void SPI_STC_vect(void)
+{
+}
+
+extern "C" __attribute__((weak)) void USART_TX_vect(void)
+{
+}
+
+extern "C" __attribute__((weak)) void TWI_vect(void)
+{
+}
+
+
+StatusRegister::operator uint8_t() const
+{
+    return lr::Simulator::areInterruptsEnabled() ? 0x80 : 0x00;
+}
+
+
+StatusRegister& StatusRegister::operator=(uint8_t value)
+{
+    lr::Simulator::setInterruptsEnabled((value & 0x80) != 0);
+    return *this;
+}
+
+
+Timer2CounterRegister::operator uint8_t() const
+{
+    return lr::Simulator::getTimer2Counter();
+}
+
+
+Timer2CounterRegister& Timer2CounterRegister::operator=(uint8_t value)
+{
+    lr::Simulator::setTimer2Counter(value);
+    return *this;
+}
+
+
+void cli()
+{
+    lr::Simulator::setInterruptsEnabled(false);
+}
+
+
+void sei()
+{
+    lr::Simulator::setInterruptsEnabled(true);
+}
+
+
+void sleep_cpu()
+{
+    lr::Simulator::sleepUntilInterrupt();
+}
+
+
+uint8_t digitalPinToPort(uint8_t pin)
+{
+    if (pin < 8) {
+        return PD;
+    } else if (pin < 14) {
+        return PB;
+    } else if (pin < cPinCount) {
+        return PC;
+    }
+    return NOT_A_PORT;
+}
+
+
+uint8_t digitalPinToBitMask(uint8_t pin)
+{
+    if (pin < 8) {
+        return _BV(pin);
+    } else if (pin < 14) {
+        return _BV(pin - 8);
+    } else if (pin < cPinCount) {
+        return _BV(pin - 14);
+    }
+    return 0;
+}
+
+
+volatile uint8_t* portOutputRegister(uint8_t port)
+{
+    return &gPortOutput[getPortIndex(port)];
+}
+
+
+volatile uint8_t* portInputRegister(uint8_t port)
+{
+    return &gPortInput[getPortIndex(port)];
+}
+
+
+volatile uint8_t* portModeRegister(uint8_t port)
+{
+    return &gPortMode[getPortIndex(port)];
+}
+
+
+volatile uint8_t* digitalPinToPCMSK(uint8_t pin)
+{
+    if (pin < 8) {
+        return &PCMSK2;
+    } else if (pin < 14) {
+        return &PCMSK0;
+    }
+    return &PCMSK1;
+}
+
+
+uint8_t digitalPinToPCMSKbit(uint8_t pin)
+{
+    if (pin < 8) {
+        return pin;
+    } else if (pin < 14) {
+        return pin - 8;
+    }
+    return pin - 14;
+}
+
+
+uint8_t digitalPinToPCICRbit(uint8_t pin)
+{
+    if (pin < 8) {
+        return PCIE2;
+    } else if (pin < 14) {
+        return PCIE0;
+    }
+    return PCIE1;
+}
+
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    const uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PORT) {
+        return;
+    }
+    const uint8_t mask = digitalPinToBitMask(pin);
+    if (mode == OUTPUT) {
+        *portModeRegister(port) |= mask;
+    } else {
+        *portModeRegister(port) &= ~mask;
+        if (mode == INPUT_PULLUP) {
+            *portOutputRegister(port) |= mask;
+        } else {
+            *portOutputRegister(port) &= ~mask;
+        }
+    }
+}
+
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    const uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PORT) {
+        return;
+    }
+    const uint8_t mask = digitalPinToBitMask(pin);
+    if (value == LOW) {
+        *portOutputRegister(port) &= ~mask;
+    } else {
+        *portOutputRegister(port) |= mask;
+    }
+}
+
+
+int digitalRead(uint8_t pin)
+{
+    const uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PORT) {
+        return LOW;
+    }
+    const uint8_t mask = digitalPinToBitMask(pin);
+    if ((*portModeRegister(port) & mask) != 0) {
+        return ((*portOutputRegister(port) & mask) != 0) ? HIGH : LOW;
+    }
+    // All inputs have an external pull-up resistor.
+    if (lr::Simulator::isPinPulledLow(pin)) {
+        *portInputRegister(port) &= ~mask;
+        return LOW;
+    }
+    *portInputRegister(port) |= mask;
+    return HIGH;
+}
+
+
+unsigned long millis()
+{
+    return static_cast<unsigned long>(lr::Simulator::getMicros() / 1000);
+}
+
+
+unsigned long micros()
+{
+    return static_cast<unsigned long>(lr::Simulator::getMicros());
+}
+
+
+void delay(unsigned long ms)
+{
+    lr::Simulator::advanceMicros(static_cast<uint64_t>(ms) * 1000);
+}
+
+
+void delayMicroseconds(unsigned int us)
+{
+    lr::Simulator::advanceMicros(us);
+}
+
@@ -0,0 +1,86 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include <avr/eeprom.h>
+
+
+#include "../sim/Simulator.h"
+
+#include <stdint.h>
+#include <string.h>
+
+
+// Simulation of the internal EEPROM of the ATmega328P.
+
+
+// The size of the EEPROM.
+static const size_t cEepromSize = E2END + 1;
+
+// The time to write one byte in microseconds.
+static const uint64_t cByteWriteMicros = 3400;
+
+
+static uint8_t gMemory[cEepromSize]; ///< The memory of the EEPROM.
+static bool gMemoryErased = false; ///< If the memory was initialized.
+
+
+// Get the memory, starting with an erased EEPROM.
+static uint8_t* getMemory()
+{
+    if (!gMemoryErased) {
+        memset(gMemory, 0xff, cEepromSize);
+        gMemoryErased = true;
+    }
+    return gMemory;
+}
+
+
+// Convert an EEPROM pointer into an address and check the range.
+static size_t getAddress(const void *pointer, size_t size)
+{
+    const size_t address = reinterpret_cast<uintptr_t>(pointer);
+    if (address + size > cEepromSize) {
+        lr::Simulator::finish("EEPROM access out of range");
+    }
+    return address;
+}
+
+
+void eeprom_read_block(void *destination, const void *source, size_t size)
+{
+    const size_t address = getAddress(source, size);
+    memcpy(destination, getMemory() + address, size);
+}
+
+
+void eeprom_update_block(const void *source, void *destination, size_t size)
+{
+    const size_t address = getAddress(destination, size);
+    uint8_t *memory = getMemory() + address;
+    const uint8_t *data = static_cast<const uint8_t*>(source);
+    for (size_t i = 0; i < size; ++i) {
+        if (memory[i] != data[i]) {
+            memory[i] = data[i];
+            // The CPU waits until each byte is written.
+            lr::Simulator::advanceMicros(cByteWriteMicros);
+        }
+    }
+}
+
+
@@ -0,0 +1,54 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "HardwareSerial.h"
+
+
+#include <stdio.h>
+
+
+HardwareSerial Serial;
+
+
+void HardwareSerial::begin(unsigned long)
+{
+}
+
+
+void HardwareSerial::end()
+{
+    flush();
+}
+
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (c == '\r') {
+        return 1; // Keep the output readable on the host.
+    }
+    putchar(c);
+    return 1;
+}
+
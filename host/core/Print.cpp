@@ -0,0 +1,214 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "Print.h"
+
+
+#include <stdio.h>
+#include <string.h>
+
+
+Print::~Print()
+{
+}
+
+
+size_t Print::write(const char *str)
+{
+    if (str == nullptr) {
+        return 0;
+    }
+    return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size-- > 0) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+
+size_t Print::printNumber(unsigned long value, uint8_t base)
+{
+    // Same format as the original, uppercase digits without prefix.
+    if (base < 2) {
+        base = 10;
+    }
+    char buffer[8 * sizeof(unsigned long) + 1];
+    char *str = &buffer[sizeof(buffer) - 1];
+    *str = '\0';
+    do {
+        const char digit = static_cast<char>(value % base);
+        value /= base;
+        *--str = digit < 10 ? digit + '0' : digit + 'A' - 10;
+    } while (value != 0);
+    return write(str);
+}
+
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+    return write(reinterpret_cast<const char*>(str));
+}
+
+
+size_t Print::print(const String &str)
+{
+    return write(reinterpret_cast<const uint8_t*>(str.c_str()), str.length());
+}
+
+
+size_t Print::print(const char str[])
+{
+    return write(str);
+}
+
+
+size_t Print::print(char c)
+{
+    return write(static_cast<uint8_t>(c));
+}
+
+
+size_t Print::print(unsigned char value, int base)
+{
+    return print(static_cast<unsigned long>(value), base);
+}
+
+
+size_t Print::print(int value, int base)
+{
+    return print(static_cast<long>(value), base);
+}
+
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print(static_cast<unsigned long>(value), base);
+}
+
+
+size_t Print::print(long value, int base)
+{
+    if (base == 0) {
+        return write(static_cast<uint8_t>(value));
+    } else if (base == 10 && value < 0) {
+        const size_t n = print('-');
+        return n + printNumber(static_cast<unsigned long>(-value), 10);
+    }
+    return printNumber(static_cast<unsigned long>(value), base);
+}
+
+
+size_t Print::print(unsigned long value, int base)
+{
+    if (base == 0) {
+        return write(static_cast<uint8_t>(value));
+    }
+    return printNumber(value, base);
+}
+
+
+size_t Print::print(double value, int digits)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+
+size_t Print::println(const __FlashStringHelper *str)
+{
+    const size_t n = print(str);
+    return n + println();
+}
+
+
+size_t Print::println(const String &str)
+{
+    const size_t n = print(str);
+    return n + println();
+}
+
+
+size_t Print::println(const char str[])
+{
+    const size_t n = print(str);
+    return n + println();
+}
+
+
+size_t Print::println(char c)
+{
+    const size_t n = print(c);
+    return n + println();
+}
+
+
+size_t Print::println(unsigned char value, int base)
+{
+    const size_t n = print(value, base);
+    return n + println();
+}
+
+
+size_t Print::println(int value, int base)
+{
+    const size_t n = print(value, base);
+    return n + println();
+}
+
+
+size_t Print::println(unsigned int value, int base)
+{
+    const size_t n = print(value, base);
+    return n + println();
+}
+
+
+size_t Print::println(long value, int base)
+{
+    const size_t n = print(value, base);
+    return n + println();
+}
+
+
+size_t Print::println(unsigned long value, int base)
+{
+    const size_t n = print(value, base);
+    return n + println();
+}
+
+
+size_t Print::println(double value, int digits)
+{
+    const size_t n = print(value, digits);
+    return n + println();
+}
+
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
@@ -0,0 +1,151 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "../sim/Simulator.h"
+#include "../sim/SpiBus.h"
+
+#include <vector>
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+
+
+// Simulation of the SPI hardware and the USART in SPI mode of the
+// ATmega328P, both in master mode and only sending.
+//
+// Writing the data register starts the transfer of the byte, which takes
+// the time of eight bits at the configured clock. After this time, the
+// byte is delivered to the SPI bus, the transfer complete flag is set and
+// the interrupt is raised, if it is enabled.
+
+
+// The simulated registers.
+volatile uint8_t SPCR;
+volatile uint8_t SPSR;
+SpiDataRegister SPDR;
+volatile uint8_t UCSR0A;
+volatile uint8_t UCSR0B;
+volatile uint8_t UCSR0C;
+volatile uint16_t UBRR0;
+UsartDataRegister UDR0;
+
+
+namespace lr {
+namespace Simulator {
+namespace Spi {
+
+
+/// Get the time for a number of cycles.
+///
+static uint64_t getCyclesMicros(uint32_t cycles)
+{
+    return ((static_cast<uint64_t>(cycles) * 1000000) + F_CPU - 1) / F_CPU;
+}
+
+
+/// Finish the transfer of the SPI hardware.
+///
+static void finishSpiTransfer()
+{
+    SpiBus::send(SPDR._value);
+    SPSR |= _BV(SPIF);
+    if ((SPCR & _BV(SPIE)) != 0) {
+        raiseInterrupt(SpiTransferInterrupt);
+    }
+}
+
+
+/// Finish the transfer of the USART.
+///
+static void finishUsartTransfer()
+{
+    SpiBus::send(UDR0._value);
+    UCSR0A |= _BV(TXC0)|_BV(UDRE0);
+    if ((UCSR0B & _BV(TXCIE0)) != 0) {
+        raiseInterrupt(UsartTransmitInterrupt);
+    }
+}
+
+
+/// Start the transfer of a byte.
+///
+static void startTransfer(uint32_t cyclesPerBit, EventCallback callback)
+{
+    const uint64_t micros = getCyclesMicros(8 * cyclesPerBit);
+    ++getStatistics().spiBytes;
+    getStatistics().spiBusMicros += micros;
+    scheduleEvent(getMicros() + micros, callback, true);
+}
+
+
+/// Process a write to the SPI data register.
+///
+static void processSpiData()
+{
+    if ((SPCR & (_BV(SPE)|_BV(MSTR))) != (_BV(SPE)|_BV(MSTR))) {
+        return; // Only the master mode is simulated.
+    }
+    static const uint8_t cDividers[4] = {4, 16, 64, 128};
+    uint32_t cyclesPerBit = cDividers[SPCR & 0x03];
+    if ((SPSR & _BV(SPI2X)) != 0) {
+        cyclesPerBit /= 2;
+    }
+    // A new byte replaces the one in transfer.
+    cancelEvents(&finishSpiTransfer);
+    SPSR &= ~_BV(SPIF);
+    clearInterrupt(SpiTransferInterrupt);
+    startTransfer(cyclesPerBit, &finishSpiTransfer);
+}
+
+
+/// Process a write to the USART data register.
+///
+static void processUsartData()
+{
+    if ((UCSR0C & (_BV(UMSEL01)|_BV(UMSEL00))) != (_BV(UMSEL01)|_BV(UMSEL00)) || (UCSR0B & _BV(TXEN0)) == 0) {
+        return; // Only the master SPI mode is simulated.
+    }
+    // The transmit buffer is not simulated, a new byte replaces the one in transfer.
+    cancelEvents(&finishUsartTransfer);
+    UCSR0A &= ~(_BV(TXC0)|_BV(UDRE0));
+    clearInterrupt(UsartTransmitInterrupt);
+    startTransfer(2 * (static_cast<uint32_t>(UBRR0) + 1), &finishUsartTransfer);
+}
+
+
+}
+}
+}
+
+
+SpiDataRegister& SpiDataRegister::operator=(uint8_t value)
+{
+    _value = value;
+    lr::Simulator::Spi::processSpiData();
+    return *this;
+}
+
+
+UsartDataRegister& UsartDataRegister::operator=(uint8_t value)
+{
+    _value = value;
+    lr::Simulator::Spi::processUsartData();
+    return *this;
+}
+
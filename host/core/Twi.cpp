@@ -0,0 +1,207 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "../sim/I2CBus.h"
+#include "../sim/Simulator.h"
+
+#include <vector>
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+
+
+// Simulation of the TWI hardware of the ATmega328P in master mode.
+//
+// Each action started by writing the control register takes the time
+// of the transferred bits on the bus. After this time, the interrupt
+// flag is set and the TWI interrupt is raised, if it is enabled.
+
+
+// The simulated registers.
+volatile uint8_t TWBR;
+volatile uint8_t TWSR;
+volatile uint8_t TWAR;
+volatile uint8_t TWDR;
+TwiControlRegister TWCR;
+
+
+namespace lr {
+namespace Simulator {
+namespace Twi {
+
+
+// The status codes of the TWI hardware in master mode.
+static const uint8_t cStatusStart = 0x08;
+static const uint8_t cStatusRepeatedStart = 0x10;
+static const uint8_t cStatusAddressWriteAck = 0x18;
+static const uint8_t cStatusAddressWriteNack = 0x20;
+static const uint8_t cStatusDataWriteAck = 0x28;
+static const uint8_t cStatusAddressReadAck = 0x40;
+static const uint8_t cStatusAddressReadNack = 0x48;
+static const uint8_t cStatusDataReadAck = 0x50;
+static const uint8_t cStatusDataReadNack = 0x58;
+static const uint8_t cStatusNoInformation = 0xf8;
+
+
+/// The state of the bus.
+///
+enum State : uint8_t {
+    Idle, ///< The bus is free.
+    Address, ///< A start condition was sent, the address is next.
+    Write, ///< In a write transaction.
+    Read, ///< In a read transaction.
+    NoDevice, ///< The address was not acknowledged.
+};
+
+
+static State gState = Idle; ///< The current state of the bus.
+static I2CDevice *gDevice = nullptr; ///< The addressed device.
+static std::vector<uint8_t> gWriteData; ///< The data of the current write transaction.
+static uint8_t gNextStatus; ///< The status at the end of the current action.
+static bool gReadNext; ///< If the current action reads a byte.
+
+
+/// Get the time for a number of bits on the bus.
+///
+static uint64_t getBitsMicros(uint8_t bits)
+{
+    static const uint8_t cPrescalers[4] = {1, 4, 16, 64};
+    const uint32_t cyclesPerBit = 16 + (2 * static_cast<uint32_t>(TWBR) * cPrescalers[TWSR & 0x03]);
+    return ((static_cast<uint64_t>(bits) * cyclesPerBit * 1000000) + F_CPU - 1) / F_CPU;
+}
+
+
+/// End the current transaction and deliver the written data.
+///
+static void endTransaction()
+{
+    if (gState == Write && gDevice != nullptr) {
+        gDevice->receive(gWriteData.data(), static_cast<uint32_t>(gWriteData.size()));
+    }
+    gWriteData.clear();
+    gDevice = nullptr;
+}
+
+
+/// Finish the current action.
+///
+static void finishAction()
+{
+    if (gReadNext) {
+        TWDR = (gDevice != nullptr) ? gDevice->transmit() : 0xff;
+    }
+    TWSR = (TWSR & 0x03) | gNextStatus;
+    TWCR._value |= _BV(TWINT);
+    if ((TWCR._value & _BV(TWIE)) != 0) {
+        raiseInterrupt(TwiInterrupt);
+    }
+}
+
+
+/// Start an action, which ends after the given number of bits.
+///
+static void startAction(uint8_t status, uint8_t bits, bool readByte)
+{
+    gNextStatus = status;
+    gReadNext = readByte;
+    const uint64_t micros = getBitsMicros(bits);
+    getStatistics().i2cBusMicros += micros;
+    scheduleEvent(getMicros() + micros, &finishAction, true);
+}
+
+
+/// Process a write to the control register.
+///
+static void processControl(uint8_t value)
+{
+    if ((value & _BV(TWEN)) == 0) {
+        // Disabling the hardware stops all actions.
+        cancelEvents(&finishAction);
+        clearInterrupt(TwiInterrupt);
+        gState = Idle;
+        gWriteData.clear();
+        gDevice = nullptr;
+        return;
+    }
+    if ((value & _BV(TWINT)) == 0) {
+        return; // No new action.
+    }
+    clearInterrupt(TwiInterrupt);
+    TWSR = (TWSR & 0x03) | cStatusNoInformation;
+    if ((value & _BV(TWSTO)) != 0) {
+        endTransaction();
+        gState = Idle;
+        getStatistics().i2cBusMicros += getBitsMicros(1);
+        TWCR._value &= ~_BV(TWSTO); // The stop condition is sent immediately.
+    }
+    if ((value & _BV(TWSTA)) != 0) {
+        const uint8_t status = (gState == Idle) ? cStatusStart : cStatusRepeatedStart;
+        endTransaction();
+        if (gState == Idle) {
+            ++getStatistics().i2cTransactions;
+        }
+        gState = Address;
+        startAction(status, 1, false);
+        return;
+    }
+    switch (gState) {
+    case Address:
+        gDevice = I2CBus::findDevice(TWDR >> 1);
+        if (gDevice == nullptr) {
+            gState = NoDevice;
+            startAction(((TWDR & 1) != 0) ? cStatusAddressReadNack : cStatusAddressWriteNack, 9, false);
+        } else if ((TWDR & 1) != 0) {
+            gState = Read;
+            gDevice->beginTransaction(true);
+            startAction(cStatusAddressReadAck, 9, false);
+        } else {
+            gState = Write;
+            gDevice->beginTransaction(false);
+            startAction(cStatusAddressWriteAck, 9, false);
+        }
+        break;
+    case Write:
+        gWriteData.push_back(static_cast<uint8_t>(TWDR));
+        ++getStatistics().i2cBytes;
+        startAction(cStatusDataWriteAck, 9, false);
+        break;
+    case Read:
+        ++getStatistics().i2cBytes;
+        startAction(((value & _BV(TWEA)) != 0) ? cStatusDataReadAck : cStatusDataReadNack, 9, true);
+        break;
+    default:
+        break;
+    }
+}
+
+
+}
+}
+}
+
+
+TwiControlRegister& TwiControlRegister::operator=(uint8_t value)
+{
+    // Writing a one to the interrupt flag clears it.
+    const uint8_t interruptFlag = ((value & _BV(TWINT)) != 0) ? 0 : (_value & _BV(TWINT));
+    _value = (value & ~_BV(TWINT)) | interruptFlag;
+    lr::Simulator::Twi::processControl(value);
+    return *this;
+}
+
@@ -0,0 +1,255 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "WString.h"
+
+
+#include <stdio.h>
+
+
+/// Convert an unsigned number into a string with the given base.
+///
+static std::string convertNumber(unsigned long value, unsigned char base)
+{
+    if (base < 2) {
+        base = 10;
+    }
+    char buffer[8 * sizeof(unsigned long) + 1];
+    char *str = &buffer[sizeof(buffer) - 1];
+    *str = '\0';
+    do {
+        const char digit = static_cast<char>(value % base);
+        value /= base;
+        *--str = digit < 10 ? digit + '0' : digit + 'a' - 10;
+    } while (value != 0);
+    return std::string(str);
+}
+
+
+/// Convert a signed number into a string with the given base.
+///
+static std::string convertNumber(long value, unsigned char base)
+{
+    if (base == 10 && value < 0) {
+        return std::string("-") + convertNumber(static_cast<unsigned long>(-value), base);
+    }
+    return convertNumber(static_cast<unsigned long>(value), base);
+}
+
+
+/// Convert a floating point number into a string.
+///
+static std::string convertFloat(double value, unsigned char decimalPlaces)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    return std::string(buffer);
+}
+
+
+String::String(const char *cstr)
+    : _buffer(cstr != nullptr ? cstr : "")
+{
+}
+
+
+String::String(const String &str)
+    : _buffer(str._buffer)
+{
+}
+
+
+String::String(const __FlashStringHelper *str)
+    : _buffer(reinterpret_cast<const char*>(str))
+{
+}
+
+
+String::String(char c)
+    : _buffer(1, c)
+{
+}
+
+
+String::String(unsigned char value, unsigned char base)
+    : _buffer(convertNumber(static_cast<unsigned long>(value), base))
+{
+}
+
+
+String::String(int value, unsigned char base)
+    : _buffer(convertNumber(static_cast<long>(value), base))
+{
+}
+
+
+String::String(unsigned int value, unsigned char base)
+    : _buffer(convertNumber(static_cast<unsigned long>(value), base))
+{
+}
+
+
+String::String(long value, unsigned char base)
+    : _buffer(convertNumber(value, base))
+{
+}
+
+
+String::String(unsigned long value, unsigned char base)
+    : _buffer(convertNumber(value, base))
+{
+}
+
+
+String::String(float value, unsigned char decimalPlaces)
+    : _buffer(convertFloat(value, decimalPlaces))
+{
+}
+
+
+String::String(double value, unsigned char decimalPlaces)
+    : _buffer(convertFloat(value, decimalPlaces))
+{
+}
+
+
+String::~String()
+{
+}
+
+
+String& String::operator=(const String &rhs)
+{
+    _buffer = rhs._buffer;
+    return *this;
+}
+
+
+String& String::operator=(const char *cstr)
+{
+    _buffer = (cstr != nullptr ? cstr : "");
+    return *this;
+}
+
+
+String& String::operator+=(const String &rhs)
+{
+    _buffer += rhs._buffer;
+    return *this;
+}
+
+
+String& String::operator+=(const char *cstr)
+{
+    if (cstr != nullptr) {
+        _buffer += cstr;
+    }
+    return *this;
+}
+
+
+String& String::operator+=(const __FlashStringHelper *str)
+{
+    return operator+=(reinterpret_cast<const char*>(str));
+}
+
+
+String& String::operator+=(char c)
+{
+    _buffer += c;
+    return *this;
+}
+
+
+bool String::operator==(const String &rhs) const
+{
+    return _buffer == rhs._buffer;
+}
+
+
+bool String::operator!=(const String &rhs) const
+{
+    return _buffer != rhs._buffer;
+}
+
+
+unsigned int String::length() const
+{
+    return static_cast<unsigned int>(_buffer.length());
+}
+
+
+char String::charAt(unsigned int index) const
+{
+    return operator[](index);
+}
+
+
+char String::operator[](unsigned int index) const
+{
+    if (index >= _buffer.length()) {
+        return 0;
+    }
+    return _buffer[index];
+}
+
+
+const char* String::c_str() const
+{
+    return _buffer.c_str();
+}
+
+
+void String::reserve(unsigned int size)
+{
+    _buffer.reserve(size);
+}
+
+
+String operator+(const String &lhs, const String &rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+
+String operator+(const String &lhs, const char *rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+
+String operator+(const String &lhs, const __FlashStringHelper *rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+
+String operator+(const String &lhs, char rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
@@ -0,0 +1,76 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+// Host replacement for the Arduino Print class.
+
+
+#include "WString.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+
+/// The base class for all character output.
+///
+class Print
+{
+public:
+    virtual ~Print();
+
+public:
+    virtual size_t write(uint8_t c) = 0;
+    size_t write(const char *str);
+    size_t write(const uint8_t *buffer, size_t size);
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const String &str);
+    size_t print(const char str[]);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println(const __FlashStringHelper *str);
+    size_t println(const String &str);
+    size_t println(const char str[]);
+    size_t println(char c);
+    size_t println(unsigned char value, int base = DEC);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(double value, int digits = 2);
+    size_t println();
+
+private:
+    size_t printNumber(unsigned long value, uint8_t base);
+};
+
@@ -0,0 +1,83 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+// Host replacement for the Arduino String class.
+
+
+#include <stdint.h>
+#include <string>
+
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+
+/// A minimal implementation of the Arduino String class.
+///
+/// The class is backed by std::string and implements the conversions
+/// and concatenations used by the firmware with the same formatting
+/// rules as the original class.
+///
+class String
+{
+public:
+    String(const char *cstr = "");
+    String(const String &str);
+    String(const __FlashStringHelper *str);
+    explicit String(char c);
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+    ~String();
+
+public:
+    String& operator=(const String &rhs);
+    String& operator=(const char *cstr);
+
+    String& operator+=(const String &rhs);
+    String& operator+=(const char *cstr);
+    String& operator+=(const __FlashStringHelper *str);
+    String& operator+=(char c);
+
+    bool operator==(const String &rhs) const;
+    bool operator!=(const String &rhs) const;
+
+    unsigned int length() const;
+    char charAt(unsigned int index) const;
+    char operator[](unsigned int index) const;
+    const char* c_str() const;
+    void reserve(unsigned int size);
+
+private:
+    std::string _buffer;
+};
+
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const String &lhs, const __FlashStringHelper *rhs);
+String operator+(const String &lhs, char rhs);
+
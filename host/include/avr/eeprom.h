@@ -0,0 +1,43 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+// Host replacement for the AVR EEPROM functions.
+//
+// The EEPROM is simulated as erased memory, which is lost at the
+// end of the simulation. Addresses are passed as pointers, like
+// on the AVR.
+
+
+#include <avr/io.h>
+
+#include <stddef.h>
+
+
+/// Read a block of bytes from the EEPROM.
+///
+void eeprom_read_block(void *destination, const void *source, size_t size);
+
+/// Write a block of bytes to the EEPROM, skipping unchanged bytes.
+///
+void eeprom_update_block(const void *source, void *destination, size_t size);
+
+
@@ -0,0 +1,44 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+// Host replacement for the AVR interrupt handling.
+//
+// Interrupt vectors are plain C functions, which are called by the
+// simulator if the corresponding event occurs and interrupts are enabled.
+
+
+#define ISR(vector, ...) extern "C" void vector(void)
+
+
+extern "C" void INT0_vect(void);
+extern "C" void PCINT0_vect(void);
+extern "C" void PCINT1_vect(void);
+extern "C" void PCINT2_vect(void);
+extern "C" void TIMER2_OVF_vect(void);
+extern "C" void SPI_STC_vect(void);
+extern "C" void USART_TX_vect(void);
+extern "C" void TWI_vect(void);
+
+
+void cli();
+void sei();
+
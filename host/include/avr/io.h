@@ -0,0 +1,215 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+// Host replacement for the AVR register definitions.
+//
+// Only the registers of the ATmega328P used by the firmware are defined.
+// They are plain variables, which are evaluated by the simulator.
+
+
+#include <stdint.h>
+
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define _BV(bit) (1 << (bit))
+
+// The last address of the internal EEPROM.
+#define E2END 0x3FF
+
+
+// Status register.
+//
+// Only the global interrupt flag is simulated, writing the register
+// enables or disables the interrupts.
+//
+class StatusRegister
+{
+public:
+    operator uint8_t() const;
+    StatusRegister& operator=(uint8_t value);
+};
+
+extern StatusRegister SREG;
+
+// Sleep mode control register.
+extern volatile uint8_t SMCR;
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+
+// External interrupts, only the low level interrupt is simulated.
+extern volatile uint8_t EICRA;
+extern volatile uint8_t EIMSK;
+extern volatile uint8_t EIFR;
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define INT0 0
+#define INT1 1
+#define INTF0 0
+#define INTF1 1
+
+// Pin change interrupts.
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCIFR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+
+// Timer/Counter 2.
+extern volatile uint8_t TCCR2A;
+extern volatile uint8_t TCCR2B;
+extern volatile uint8_t OCR2A;
+extern volatile uint8_t OCR2B;
+extern volatile uint8_t TIMSK2;
+extern volatile uint8_t ASSR;
+/// The counter register of timer 2.
+///
+/// The simulator only computes the counter when it is read or written,
+/// therefore it is not a plain variable like the other registers.
+///
+class Timer2CounterRegister
+{
+public:
+    operator uint8_t() const;
+    Timer2CounterRegister& operator=(uint8_t value);
+};
+
+extern Timer2CounterRegister TCNT2;
+#define WGM20 0
+#define WGM21 1
+#define WGM22 3
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+
+// Two-wire serial interface (TWI).
+extern volatile uint8_t TWBR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWAR;
+extern volatile uint8_t TWDR;
+#define TWPS0 0
+#define TWPS1 1
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+
+/// The TWI control register.
+///
+/// Writing this register starts the actions of the simulated TWI hardware,
+/// therefore it is not a plain variable like the other registers.
+///
+class TwiControlRegister
+{
+public:
+    inline operator uint8_t() const { return _value; }
+    TwiControlRegister& operator=(uint8_t value);
+    inline TwiControlRegister& operator|=(uint8_t value) { return operator=(_value | value); }
+    inline TwiControlRegister& operator&=(uint8_t value) { return operator=(_value & value); }
+
+public:
+    volatile uint8_t _value;
+};
+
+extern TwiControlRegister TWCR;
+
+// Serial peripheral interface (SPI).
+extern volatile uint8_t SPCR;
+extern volatile uint8_t SPSR;
+#define SPR0 0
+#define SPR1 1
+#define CPHA 2
+#define CPOL 3
+#define MSTR 4
+#define DORD 5
+#define SPE 6
+#define SPIE 7
+#define SPI2X 0
+#define WCOL 6
+#define SPIF 7
+
+/// The SPI data register.
+///
+/// Writing this register starts a transfer of the simulated SPI hardware.
+///
+class SpiDataRegister
+{
+public:
+    inline operator uint8_t() const { return _value; }
+    SpiDataRegister& operator=(uint8_t value);
+
+public:
+    volatile uint8_t _value;
+};
+
+extern SpiDataRegister SPDR;
+
+// USART 0, only the master SPI mode is simulated.
+extern volatile uint8_t UCSR0A;
+extern volatile uint8_t UCSR0B;
+extern volatile uint8_t UCSR0C;
+extern volatile uint16_t UBRR0;
+#define UDRE0 5
+#define TXC0 6
+#define TXEN0 3
+#define UDRIE0 5
+#define TXCIE0 6
+#define UCPOL0 0
+#define UCPHA0 1
+#define UDORD0 2
+#define UMSEL00 6
+#define UMSEL01 7
+
+/// The USART data register.
+///
+/// Writing this register starts a transfer of the simulated USART hardware.
+///
+class UsartDataRegister
+{
+public:
+    inline operator uint8_t() const { return _value; }
+    UsartDataRegister& operator=(uint8_t value);
+
+public:
+    volatile uint8_t _value;
+};
+
+extern UsartDataRegister UDR0;
+
@@ -0,0 +1,156 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "DHT22.h"
+
+
+#include "Simulator.h"
+
+
+namespace lr {
+namespace DHT22 {
+
+
+// The time of a read, 20ms start signal and ~5ms for the transfer of the 40 bits.
+static const uint64_t cReadDurationMicros = 25000;
+
+// The time between the start signals of two channels.
+static const uint64_t cChannelIntervalMicros = 6000;
+
+static uint8_t gPins[cMaximumChannelCount]; ///< The pins to read from.
+static uint8_t gChannelCount; ///< The number of channels.
+static bool gReadStarted; ///< If a read was started.
+static uint64_t gReadEndMicros; ///< The time when the read is finished.
+static uint32_t gReadTime; ///< The time of the current read in seconds.
+static uint8_t gMaximumMeasurementAge = 2; ///< The maximum age of a cached measurement in seconds.
+
+
+void begin(uint8_t pin)
+{
+    begin(&pin, 1);
+}
+
+
+void begin(const uint8_t *pins, uint8_t channelCount)
+{
+    gChannelCount = min(channelCount, cMaximumChannelCount);
+    for (uint8_t channel = 0; channel < gChannelCount; ++channel) {
+        gPins[channel] = pins[channel];
+        pinMode(gPins[channel], INPUT);
+        digitalWrite(gPins[channel], HIGH);
+    }
+    gReadStarted = false;
+}
+
+
+uint8_t getChannelCount()
+{
+    return gChannelCount;
+}
+
+
+// The duration of a read of all channels with overlapping start signals.
+static uint64_t getReadDurationMicros()
+{
+    return cReadDurationMicros + cChannelIntervalMicros * (gChannelCount - 1);
+}
+
+
+void startRead(uint32_t time)
+{
+    ++Simulator::getStatistics().sensorReads;
+    gReadStarted = true;
+    gReadTime = time;
+    gReadEndMicros = Simulator::getMicros() + getReadDurationMicros();
+}
+
+
+bool isReadFinished()
+{
+    return Simulator::getMicros() >= gReadEndMicros;
+}
+
+
+Measurement getReadResult(uint8_t channel)
+{
+    return getCachedMeasurement(channel);
+}
+
+
+void setMaximumMeasurementAge(uint8_t seconds)
+{
+    gMaximumMeasurementAge = seconds;
+}
+
+
+// If the last read has finished and its values are in the cache.
+static bool hasCachedMeasurement()
+{
+    return gReadStarted && isReadFinished();
+}
+
+
+bool isMeasurementFresh(uint32_t time)
+{
+    return hasCachedMeasurement() && time >= gReadTime && (time - gReadTime) <= gMaximumMeasurementAge;
+}
+
+
+Measurement getCachedMeasurement(uint8_t channel)
+{
+    if (!hasCachedMeasurement() || channel >= gChannelCount) {
+        Measurement measurement = {NAN, NAN};
+        return measurement;
+    }
+    // Simulate a daily cycle with the resolution of the sensor (0.1),
+    // each channel is a bit warmer than the previous one.
+    const double day = static_cast<double>(gReadEndMicros) / (86400.0 * 1000000.0);
+    const double phase = sin(day * 2.0 * M_PI);
+    Measurement measurement;
+    measurement.temperature = roundf(static_cast<float>(21.0 + 4.0 * phase + 0.5 * channel) * 10.0f) / 10.0f;
+    measurement.humidity = roundf(static_cast<float>(45.0 - 12.0 * phase - 1.0 * channel) * 10.0f) / 10.0f;
+    return measurement;
+}
+
+
+ReadTiming getReadTiming(uint8_t channel)
+{
+    // The simulated sensor always sends with the nominal timing.
+    ReadTiming timing = {NoError, 42, 160, 76, 76, 120, 120};
+    if (!hasCachedMeasurement() || channel >= gChannelCount) {
+        timing.error = ReadNotFinished;
+    }
+    return timing;
+}
+
+
+Measurement readTemperatureAndHumidity(uint32_t time)
+{
+    if (!isMeasurementFresh(time)) {
+        // Like the original implementation, wait until the read has finished.
+        startRead(time);
+        Simulator::advanceMicros(getReadDurationMicros());
+    }
+    return getCachedMeasurement();
+}
+
+
+}
+}
+
@@ -0,0 +1,280 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "DS3231Device.h"
+
+
+#include "Simulator.h"
+
+#include "DateTime.h"
+
+
+namespace lr {
+namespace Simulator {
+
+
+// The registers used for the alarms.
+static const uint8_t cAlarm1Register = 0x07;
+static const uint8_t cAlarm2Register = 0x0b;
+static const uint8_t cControlRegister = 0x0e;
+static const uint8_t cStatusRegister = 0x0f;
+
+// The bit to ignore a value of an alarm.
+static const uint8_t cAlarmMaskBit = 0x80;
+
+// The bit to select the day of the week for an alarm.
+static const uint8_t cAlarmDayOfWeekBit = 0x40;
+
+// The bit to enable the alarm interrupts on the INT/SQW output.
+static const uint8_t cInterruptControlBit = 0x04;
+
+// The maximum time searched for the next alarm, a bit more than a month.
+static const uint32_t cMaximumAlarmSearchSeconds = 62 * 86400;
+
+
+DS3231Device *DS3231Device::_alarmDevice = nullptr;
+
+
+// Function to convert BCD format into binary format.
+static inline uint8_t convertBcdToBin(const uint8_t bcd)
+{
+    return (bcd&0xf)+((bcd>>4)*10);
+}
+
+
+// Function to convert binary to BCD format.
+static inline uint8_t convertBinToBcd(const uint8_t bin)
+{
+    return (bin%10)+((bin/10)<<4);
+}
+
+
+DS3231Device::DS3231Device(uint32_t secondsSince2000, uint8_t interruptPin)
+    : I2CDevice(0x68), _registerPointer(0), _offsetSeconds(secondsSince2000), _interruptPin(interruptPin)
+{
+    memset(_registers, 0, cRegisterCount);
+    _registers[0x0e] = 0x1c; // Power-on state of the control register.
+    _registers[0x11] = 21; // 21.25°C
+    _registers[0x12] = 0x40;
+    _alarmDevice = this;
+}
+
+
+DS3231Device::~DS3231Device()
+{
+    if (_alarmDevice == this) {
+        cancelEvents(&onAlarmEvent);
+        _alarmDevice = nullptr;
+    }
+}
+
+
+uint32_t DS3231Device::getSecondsSince2000() const
+{
+    return static_cast<uint32_t>(_offsetSeconds + static_cast<int64_t>(getMicros() / 1000000));
+}
+
+
+void DS3231Device::beginTransaction(bool read)
+{
+    // The time registers are copied into a buffer at the start of a
+    // transaction, so the time can not change while it is read.
+    if (read) {
+        updateTimeRegisters();
+    }
+}
+
+
+void DS3231Device::receive(const uint8_t *data, uint32_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    updateTimeRegisters();
+    _registerPointer = data[0] % cRegisterCount;
+    bool timeChanged = false;
+    bool alarmsChanged = false;
+    for (uint32_t i = 1; i < count; ++i) {
+        if (_registerPointer < cAlarm1Register) {
+            timeChanged = true;
+        } else if (_registerPointer <= cStatusRegister) {
+            alarmsChanged = true;
+        }
+        if (_registerPointer == cStatusRegister) {
+            // The alarm flags can only be cleared.
+            const uint8_t flags = _registers[cStatusRegister] & 0x03;
+            _registers[cStatusRegister] = (data[i] & ~0x03) | (data[i] & flags);
+        } else {
+            _registers[_registerPointer] = data[i];
+        }
+        _registerPointer = (_registerPointer + 1) % cRegisterCount;
+    }
+    if (timeChanged) {
+        updateTimeFromRegisters();
+    }
+    if (timeChanged || alarmsChanged) {
+        updateInterruptOutput();
+        scheduleNextAlarm();
+    }
+}
+
+
+uint8_t DS3231Device::transmit()
+{
+    const uint8_t data = _registers[_registerPointer];
+    _registerPointer = (_registerPointer + 1) % cRegisterCount;
+    return data;
+}
+
+
+void DS3231Device::updateTimeRegisters()
+{
+    const DateTime dateTime = DateTime::fromSecondsSince2000(getSecondsSince2000());
+    _registers[0x00] = convertBinToBcd(dateTime.getSecond());
+    _registers[0x01] = convertBinToBcd(dateTime.getMinute());
+    _registers[0x02] = convertBinToBcd(dateTime.getHour());
+    _registers[0x03] = dateTime.getDayOfWeek();
+    _registers[0x04] = convertBinToBcd(dateTime.getDay());
+    _registers[0x05] = convertBinToBcd(dateTime.getMonth()) | (dateTime.getYear() >= 2100 ? 0x80 : 0x00);
+    _registers[0x06] = convertBinToBcd(dateTime.getYear() % 100);
+}
+
+
+void DS3231Device::updateTimeFromRegisters()
+{
+    const uint16_t year = 2000 + convertBcdToBin(_registers[0x06]) + ((_registers[0x05] & 0x80) != 0 ? 100 : 0);
+    const DateTime dateTime(
+        year,
+        convertBcdToBin(_registers[0x05] & 0x1f),
+        convertBcdToBin(_registers[0x04] & 0x3f),
+        convertBcdToBin(_registers[0x02] & 0x3f),
+        convertBcdToBin(_registers[0x01] & 0x7f),
+        convertBcdToBin(_registers[0x00] & 0x7f));
+    _offsetSeconds = static_cast<int64_t>(dateTime.toSecondsSince2000()) - static_cast<int64_t>(getMicros() / 1000000);
+}
+
+
+bool DS3231Device::isAlarmMatching(uint8_t alarm, uint32_t secondsSince2000) const
+{
+    // Alarm 2 has no seconds register and triggers at second zero.
+    uint8_t registers[4];
+    if (alarm == 0) {
+        memcpy(registers, _registers + cAlarm1Register, 4);
+    } else {
+        registers[0] = 0x00;
+        memcpy(registers + 1, _registers + cAlarm2Register, 3);
+    }
+    const DateTime dateTime = DateTime::fromSecondsSince2000(secondsSince2000);
+    if ((registers[0] & cAlarmMaskBit) == 0 && convertBcdToBin(registers[0] & 0x7f) != dateTime.getSecond()) {
+        return false;
+    }
+    if ((registers[1] & cAlarmMaskBit) == 0 && convertBcdToBin(registers[1] & 0x7f) != dateTime.getMinute()) {
+        return false;
+    }
+    if ((registers[2] & cAlarmMaskBit) == 0 && convertBcdToBin(registers[2] & 0x3f) != dateTime.getHour()) {
+        return false;
+    }
+    if ((registers[3] & cAlarmMaskBit) == 0) {
+        if ((registers[3] & cAlarmDayOfWeekBit) != 0) {
+            if ((registers[3] & 0x07) != dateTime.getDayOfWeek()) {
+                return false;
+            }
+        } else if (convertBcdToBin(registers[3] & 0x3f) != dateTime.getDay()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+uint32_t DS3231Device::getNextAlarmTime(uint8_t alarm) const
+{
+    const uint32_t now = getSecondsSince2000();
+    uint32_t time = now + 1;
+    uint32_t step = 1;
+    // If the seconds have to match, only check one second of each minute.
+    const uint8_t secondsRegister = (alarm == 0) ? _registers[cAlarm1Register] : 0x00;
+    if ((secondsRegister & cAlarmMaskBit) == 0) {
+        const uint32_t second = convertBcdToBin(secondsRegister & 0x7f) % 60;
+        time += (second + 60 - (time % 60)) % 60;
+        step = 60;
+    }
+    for (; time <= now + cMaximumAlarmSearchSeconds; time += step) {
+        if (isAlarmMatching(alarm, time)) {
+            return time;
+        }
+    }
+    return 0;
+}
+
+
+void DS3231Device::scheduleNextAlarm()
+{
+    cancelEvents(&onAlarmEvent);
+    uint32_t nextTime = 0;
+    for (uint8_t alarm = 0; alarm < 2; ++alarm) {
+        if ((_registers[cControlRegister] & (1 << alarm)) == 0) {
+            continue;
+        }
+        const uint32_t time = getNextAlarmTime(alarm);
+        if (time != 0 && (nextTime == 0 || time < nextTime)) {
+            nextTime = time;
+        }
+    }
+    if (nextTime != 0) {
+        // The clock increments the seconds at the start of each second of the virtual time.
+        const int64_t micros = (static_cast<int64_t>(nextTime) - _offsetSeconds) * 1000000;
+        scheduleEvent(static_cast<uint64_t>(micros), &onAlarmEvent, false);
+    }
+}
+
+
+void DS3231Device::updateInterruptOutput()
+{
+    const uint8_t enabledFlags = _registers[cStatusRegister] & _registers[cControlRegister] & 0x03;
+    const bool isLow = (_registers[cControlRegister] & cInterruptControlBit) != 0 && enabledFlags != 0;
+    setPinPulledLow(_interruptPin, isLow);
+}
+
+
+void DS3231Device::triggerAlarms()
+{
+    const uint32_t now = getSecondsSince2000();
+    for (uint8_t alarm = 0; alarm < 2; ++alarm) {
+        if ((_registers[cControlRegister] & (1 << alarm)) != 0 && isAlarmMatching(alarm, now)) {
+            _registers[cStatusRegister] |= (1 << alarm);
+        }
+    }
+    updateInterruptOutput();
+    scheduleNextAlarm();
+}
+
+
+void DS3231Device::onAlarmEvent()
+{
+    if (_alarmDevice != nullptr) {
+        _alarmDevice->triggerAlarms();
+    }
+}
+
+
+}
+}
+
+
@@ -0,0 +1,112 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include "I2CBus.h"
+
+
+namespace lr {
+namespace Simulator {
+
+
+/// A simulated DS3231 real time clock.
+///
+/// The clock runs with the virtual time of the simulator. The alarms
+/// pull the INT/SQW output low, if their interrupt is enabled. The alarm
+/// flags are only set for alarms with enabled interrupt.
+///
+class DS3231Device : public I2CDevice
+{
+public:
+    /// Create a new real time clock.
+    ///
+    /// @param secondsSince2000 The initial time of the clock.
+    /// @param interruptPin The pin connected to the INT/SQW output.
+    ///
+    explicit DS3231Device(uint32_t secondsSince2000, uint8_t interruptPin = 2);
+    
+    /// dtor
+    ///
+    ~DS3231Device();
+
+public:
+    virtual void beginTransaction(bool read);
+    virtual void receive(const uint8_t *data, uint32_t count);
+    virtual uint8_t transmit();
+
+    /// Get the current time of the clock in seconds since 2000.
+    ///
+    uint32_t getSecondsSince2000() const;
+
+private:
+    /// Update the time registers from the virtual time.
+    ///
+    void updateTimeRegisters();
+
+    /// Set the clock from the values in the time registers.
+    ///
+    void updateTimeFromRegisters();
+
+    /// Check if an alarm matches the given time.
+    ///
+    /// @param alarm The alarm, 0 for alarm 1 and 1 for alarm 2.
+    /// @param secondsSince2000 The time to check.
+    ///
+    bool isAlarmMatching(uint8_t alarm, uint32_t secondsSince2000) const;
+
+    /// Get the next time an alarm triggers.
+    ///
+    /// @param alarm The alarm, 0 for alarm 1 and 1 for alarm 2.
+    /// @return The time in seconds since 2000, or zero if it never triggers.
+    ///
+    uint32_t getNextAlarmTime(uint8_t alarm) const;
+
+    /// Schedule the event for the next alarm with enabled interrupt.
+    ///
+    void scheduleNextAlarm();
+
+    /// Set the INT/SQW output from the alarm flags.
+    ///
+    void updateInterruptOutput();
+
+    /// Set the flags of the triggered alarms.
+    ///
+    void triggerAlarms();
+
+    /// The event callback for the alarms.
+    ///
+    static void onAlarmEvent();
+
+private:
+    static const uint8_t cRegisterCount = 0x13;
+
+    uint8_t _registers[cRegisterCount];
+    uint8_t _registerPointer;
+    int64_t _offsetSeconds;
+    uint8_t _interruptPin;
+    
+    static DS3231Device *_alarmDevice; ///< The device which receives the alarm events.
+};
+
+
+}
+}
+
@@ -0,0 +1,130 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "FileStorage.h"
+
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+namespace lr {
+namespace Simulator {
+namespace FileStorage {
+
+
+// The size of the storage, matching the FRAM chip.
+static const uint32_t cSize = 32768;
+
+
+static const char *gPath = nullptr; ///< The path to the file or nullptr.
+static uint8_t *gMemory = nullptr; ///< The mapped memory.
+
+
+// forward declarations
+bool begin();
+uint32_t size();
+void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size);
+void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size);
+
+
+// The functions of this backend.
+static const Storage::Backend cBackend = {
+    &begin,
+    &size,
+    &readBytes,
+    nullptr,
+    nullptr,
+    &writeBytes,
+    nullptr,
+    nullptr,
+    false
+};
+
+
+void setPath(const char *path)
+{
+    gPath = path;
+}
+
+
+const Storage::Backend* getBackend()
+{
+    return &cBackend;
+}
+
+
+bool begin()
+{
+    if (gMemory != nullptr) {
+        return true;
+    }
+    void *memory;
+    if (gPath != nullptr) {
+        const int file = open(gPath, O_RDWR|O_CREAT, 0644);
+        if (file < 0) {
+            perror(gPath);
+            return false;
+        }
+        const off_t fileSize = lseek(file, 0, SEEK_END);
+        if (fileSize < static_cast<off_t>(cSize) && ftruncate(file, cSize) != 0) {
+            perror(gPath);
+            close(file);
+            return false;
+        }
+        memory = mmap(nullptr, cSize, PROT_READ|PROT_WRITE, MAP_SHARED, file, 0);
+        close(file); // The mapping keeps the file open.
+    } else {
+        memory = mmap(nullptr, cSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    }
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    gMemory = static_cast<uint8_t*>(memory);
+    return true;
+}
+
+
+uint32_t size()
+{
+    return cSize;
+}
+
+
+void readBytes(uint32_t firstIndex, uint8_t *data, uint32_t size)
+{
+    memcpy(data, gMemory + firstIndex, size);
+}
+
+
+void writeBytes(uint32_t firstIndex, const uint8_t *data, uint32_t size)
+{
+    memcpy(gMemory + firstIndex, data, size);
+}
+
+
+}
+}
+}
+
+
@@ -0,0 +1,57 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include "Storage.h"
+
+
+namespace lr {
+namespace Simulator {
+
+
+/// A storage backend using a memory mapped file.
+///
+/// The log and the settings are accessed at memory speed, without
+/// the simulated I2C bus. This is used to run the log system as
+/// fast as possible on the development machine.
+///
+namespace FileStorage {
+
+
+/// Set the file for the storage.
+///
+/// The file is created or extended to the size of the storage.
+/// Without a file, the storage uses anonymous memory.
+///
+/// @param path The path to the file or nullptr.
+///
+void setPath(const char *path);
+
+/// Get the backend for the storage.
+///
+const Storage::Backend* getBackend();
+
+
+}
+}
+}
+
+
@@ -0,0 +1,107 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "FramDevice.h"
+
+
+namespace lr {
+namespace Simulator {
+
+
+FramDevice::FramDevice(uint8_t address, uint32_t size)
+    : I2CDevice(address), _memory(size, 0), _addressPointer(0)
+{
+}
+
+
+void FramDevice::receive(const uint8_t *data, uint32_t count)
+{
+    if (count < 2) {
+        return; // Incomplete address.
+    }
+    _addressPointer = ((static_cast<uint32_t>(data[0]) << 8) | data[1]) % getSize();
+    for (uint32_t i = 2; i < count; ++i) {
+        _memory[_addressPointer] = data[i];
+        _addressPointer = (_addressPointer + 1) % getSize();
+    }
+}
+
+
+uint8_t FramDevice::transmit()
+{
+    const uint8_t data = _memory[_addressPointer];
+    _addressPointer = (_addressPointer + 1) % getSize();
+    return data;
+}
+
+
+bool FramDevice::loadFromFile(FILE *file)
+{
+    const size_t readSize = fread(_memory.data(), 1, _memory.size(), file);
+    return readSize == _memory.size();
+}
+
+
+bool FramDevice::saveToFile(FILE *file) const
+{
+    const size_t writeSize = fwrite(_memory.data(), 1, _memory.size(), file);
+    return writeSize == _memory.size();
+}
+
+
+FramDeviceIdResponder::FramDeviceIdResponder()
+    : I2CDevice(0xf8>>1), _requestedAddress(0), _transmitIndex(0)
+{
+}
+
+
+void FramDeviceIdResponder::beginTransaction(bool)
+{
+    _transmitIndex = 0;
+}
+
+
+void FramDeviceIdResponder::receive(const uint8_t *data, uint32_t count)
+{
+    if (count > 0) {
+        _requestedAddress = data[0] >> 1;
+    }
+}
+
+
+uint8_t FramDeviceIdResponder::transmit()
+{
+    // Fujitsu manufacturer ID 0x00a, followed by the product ID.
+    uint8_t id[3] = {0xff, 0xff, 0xff};
+    FramDevice *fram = dynamic_cast<FramDevice*>(I2CBus::findDevice(_requestedAddress));
+    if (fram != nullptr) {
+        const uint16_t productId = fram->getProductId();
+        id[0] = 0x00;
+        id[1] = 0xa0 | static_cast<uint8_t>(productId >> 8);
+        id[2] = static_cast<uint8_t>(productId & 0xff);
+    }
+    const uint8_t data = (_transmitIndex < 3) ? id[_transmitIndex] : 0xff;
+    ++_transmitIndex;
+    return data;
+}
+
+
+}
+}
+
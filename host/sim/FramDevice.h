@@ -0,0 +1,101 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include "I2CBus.h"
+
+#include <stdio.h>
+#include <vector>
+
+
+namespace lr {
+namespace Simulator {
+
+
+/// A simulated MB85RC256V FRAM chip.
+///
+/// The chip uses a two byte address, which is automatically
+/// incremented after each read or written byte.
+///
+class FramDevice : public I2CDevice
+{
+public:
+    /// Create a new FRAM chip.
+    ///
+    /// @param address The 7-bit address of the chip (1010AAA).
+    /// @param size The size of the memory in bytes.
+    ///
+    FramDevice(uint8_t address, uint32_t size = 32768);
+
+public:
+    virtual void receive(const uint8_t *data, uint32_t count);
+    virtual uint8_t transmit();
+
+    /// Get the size of the memory.
+    ///
+    inline uint32_t getSize() const { return static_cast<uint32_t>(_memory.size()); }
+
+    /// Get the product ID reported by the device ID command.
+    ///
+    inline uint16_t getProductId() const { return 0x510; }
+
+    /// Load the memory contents from the current position of a file.
+    ///
+    /// @return true on success, false if the file could not be read.
+    ///
+    bool loadFromFile(FILE *file);
+
+    /// Save the memory contents at the current position of a file.
+    ///
+    /// @return true on success, false if the file could not be written.
+    ///
+    bool saveToFile(FILE *file) const;
+
+private:
+    std::vector<uint8_t> _memory;
+    uint32_t _addressPointer;
+};
+
+
+/// The reserved device ID address of the bus.
+///
+/// A FRAM chip reports its manufacturer and product ID if its address
+/// is written to this address, followed by a read of three bytes.
+///
+class FramDeviceIdResponder : public I2CDevice
+{
+public:
+    FramDeviceIdResponder();
+
+public:
+    virtual void beginTransaction(bool read);
+    virtual void receive(const uint8_t *data, uint32_t count);
+    virtual uint8_t transmit();
+
+private:
+    uint8_t _requestedAddress;
+    uint8_t _transmitIndex;
+};
+
+
+}
+}
+
@@ -0,0 +1,72 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "I2CBus.h"
+
+
+#include <vector>
+
+
+namespace lr {
+namespace Simulator {
+
+
+I2CDevice::I2CDevice(uint8_t address)
+    : _address(address)
+{
+}
+
+
+I2CDevice::~I2CDevice()
+{
+}
+
+
+void I2CDevice::beginTransaction(bool)
+{
+}
+
+
+namespace I2CBus {
+
+
+static std::vector<I2CDevice*> gDevices; ///< All attached devices.
+
+
+void attach(I2CDevice *device)
+{
+    gDevices.push_back(device);
+}
+
+
+I2CDevice* findDevice(uint8_t address)
+{
+    for (I2CDevice *device : gDevices) {
+        if (device->getAddress() == address) {
+            return device;
+        }
+    }
+    return nullptr;
+}
+
+
+}
+}
+}
+
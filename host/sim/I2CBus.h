@@ -0,0 +1,93 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include <stdint.h>
+
+
+namespace lr {
+namespace Simulator {
+
+
+/// The base class of all simulated devices on the I2C bus.
+///
+class I2CDevice
+{
+public:
+    /// Create a new device with the given 7-bit address.
+    ///
+    explicit I2CDevice(uint8_t address);
+
+    /// dtor
+    ///
+    virtual ~I2CDevice();
+
+public:
+    /// Get the 7-bit address of this device.
+    ///
+    inline uint8_t getAddress() const { return _address; }
+
+    /// Start a new transaction.
+    ///
+    /// The device acknowledges its address in any case.
+    ///
+    /// @param read If this is a read transaction.
+    ///
+    virtual void beginTransaction(bool read);
+
+    /// Receive the data of a write transaction.
+    ///
+    /// This is called at the end of the transaction.
+    ///
+    /// @param data The bytes sent after the address.
+    /// @param count The number of bytes.
+    ///
+    virtual void receive(const uint8_t *data, uint32_t count) = 0;
+
+    /// Transmit the next byte of a read transaction.
+    ///
+    virtual uint8_t transmit() = 0;
+
+private:
+    uint8_t _address;
+};
+
+
+/// The simulated I2C bus.
+///
+namespace I2CBus {
+
+
+/// Attach a device to the bus.
+///
+void attach(I2CDevice *device);
+
+/// Find the device with the given address.
+///
+/// @return The device or nullptr if there is no device with this address.
+///
+I2CDevice* findDevice(uint8_t address);
+
+
+}
+}
+}
+
@@ -0,0 +1,141 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "SharpDisplayDevice.h"
+
+
+#include <string.h>
+
+
+namespace lr {
+namespace Simulator {
+
+
+// The bits of the command byte.
+static const uint8_t cCommandWrite = 0x80;
+static const uint8_t cCommandVCom = 0x40;
+static const uint8_t cCommandClear = 0x20;
+
+
+/// Reverse the bits of a byte, the line address is sent LSB first.
+///
+static uint8_t reverseBits(uint8_t byte)
+{
+    uint8_t result = 0;
+    for (uint8_t i = 0; i < 8; ++i) {
+        result = (result << 1) | (byte & 1);
+        byte >>= 1;
+    }
+    return result;
+}
+
+
+SharpDisplayDevice::SharpDisplayDevice()
+    : _state(CommandState), _line(0), _column(0), _lastVComBit(0), _frameCount(0), _errorCount(0)
+{
+    memset(_pixels, 0xff, sizeof(_pixels));
+}
+
+
+void SharpDisplayDevice::receive(uint8_t byte)
+{
+    switch (_state) {
+        case CommandState:
+            if ((byte & ~(cCommandWrite|cCommandVCom|cCommandClear)) != 0) {
+                ++_errorCount;
+            }
+            // The VCOM bit has to change with each frame.
+            if (_frameCount > 0 && (byte & cCommandVCom) == _lastVComBit) {
+                ++_errorCount;
+            }
+            _lastVComBit = (byte & cCommandVCom);
+            if ((byte & cCommandClear) != 0) {
+                memset(_pixels, 0xff, sizeof(_pixels));
+            }
+            _state = ((byte & cCommandWrite) != 0) ? AddressState : CommandEndState;
+            break;
+
+        case CommandEndState:
+            if (byte != 0) {
+                ++_errorCount;
+            }
+            ++_frameCount;
+            _state = CommandState;
+            break;
+
+        case AddressState:
+            if (byte == 0) {
+                ++_frameCount;
+                _state = CommandState;
+                break;
+            }
+            _line = reverseBits(byte);
+            if (_line > cHeight) {
+                ++_errorCount;
+                _line = 0; // Ignore the data of the line.
+            }
+            _column = 0;
+            _state = DataState;
+            break;
+
+        case DataState:
+            if (_line > 0) {
+                _pixels[_line-1][_column] = byte;
+            }
+            if (++_column == cBytesPerLine) {
+                _state = LineEndState;
+            }
+            break;
+
+        case LineEndState:
+            if (byte != 0) {
+                ++_errorCount;
+            }
+            _state = AddressState;
+            break;
+    }
+}
+
+
+bool SharpDisplayDevice::isPixelSet(uint8_t x, uint8_t y) const
+{
+    if (x >= cWidth || y >= cHeight) {
+        return false;
+    }
+    return (_pixels[y][x/8] & (0x80 >> (x%8))) == 0;
+}
+
+
+bool SharpDisplayDevice::saveToFile(FILE *file) const
+{
+    bool success = fprintf(file, "P4\n%u %u\n", cWidth, cHeight) > 0;
+    for (uint8_t y = 0; y < cHeight && success; ++y) {
+        uint8_t line[cBytesPerLine];
+        for (uint8_t i = 0; i < cBytesPerLine; ++i) {
+            line[i] = ~_pixels[y][i]; // In a bitmap, set bits are black.
+        }
+        success = fwrite(line, 1, cBytesPerLine, file) == cBytesPerLine;
+    }
+    return success;
+}
+
+
+}
+}
+
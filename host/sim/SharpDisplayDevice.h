@@ -0,0 +1,95 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include "SpiBus.h"
+
+#include <stdio.h>
+
+
+namespace lr {
+namespace Simulator {
+
+
+/// A simulated Sharp LS013B4DN04 memory display with 96x96 pixels.
+///
+/// The display decodes the frames sent using the SPI hardware or the
+/// USART into its pixels. Bytes which do not follow the protocol are
+/// counted as errors. The bytes of the software interface are not
+/// received, because it sets the pins directly.
+///
+class SharpDisplayDevice : public SpiDevice
+{
+public:
+    /// Create a new display, with all pixels white.
+    ///
+    SharpDisplayDevice();
+
+public:
+    virtual void receive(uint8_t byte);
+
+    /// Get the number of complete frames.
+    ///
+    inline uint32_t getFrameCount() const { return _frameCount; }
+
+    /// Get the number of bytes which did not follow the protocol.
+    ///
+    inline uint32_t getErrorCount() const { return _errorCount; }
+
+    /// Check if a pixel is black.
+    ///
+    bool isPixelSet(uint8_t x, uint8_t y) const;
+
+    /// Save the pixels as portable bitmap (PBM) at the current position of a file.
+    ///
+    /// @return true on success, false if the file could not be written.
+    ///
+    bool saveToFile(FILE *file) const;
+
+private:
+    /// The states of the protocol.
+    ///
+    enum State : uint8_t {
+        CommandState, ///< Waiting for a command.
+        CommandEndState, ///< Waiting for the trailer of a command without data.
+        AddressState, ///< Waiting for a line address or the end of the frame.
+        DataState, ///< Receiving the pixels of a line.
+        LineEndState, ///< Waiting for the trailer of a line.
+    };
+
+    static const uint8_t cWidth = 96;
+    static const uint8_t cHeight = 96;
+    static const uint8_t cBytesPerLine = cWidth / 8;
+
+private:
+    uint8_t _pixels[cHeight][cBytesPerLine];
+    State _state;
+    uint8_t _line;
+    uint8_t _column;
+    uint8_t _lastVComBit;
+    uint32_t _frameCount;
+    uint32_t _errorCount;
+};
+
+
+}
+}
+
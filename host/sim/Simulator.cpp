@@ -0,0 +1,481 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "Simulator.h"
+
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+
+namespace lr {
+namespace Simulator {
+
+
+/// A scheduled key press.
+///
+struct KeyPress {
+    uint8_t pin; ///< The pin which is pulled low.
+    uint64_t startMicros; ///< The start of the key press.
+    uint64_t endMicros; ///< The end of the key press.
+};
+
+
+/// A scheduled event of the simulated hardware.
+///
+struct Event {
+    EventCallback callback; ///< The function to call.
+    bool requiresIoClock; ///< If the event requires the I/O clock.
+};
+
+
+// The pin of the external interrupt INT0.
+static const uint8_t cExternalInterrupt0Pin = 2;
+
+// The prescaler values for the CS2x bits of timer 2.
+static const uint16_t cTimer2Prescalers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+static uint64_t gMicros; ///< The current virtual time.
+static uint64_t gTimeLimitMicros; ///< The virtual time when the simulation ends.
+static uint64_t gNextTimer2Overflow; ///< The virtual time of the next timer 2 overflow.
+static uint8_t gTimer2Counter; ///< The timer 2 counter, while the timer is stopped.
+static bool gInterruptsEnabled; ///< If interrupts are enabled.
+static uint32_t gPendingInterrupts; ///< A bit for each pending interrupt vector.
+static uint32_t gCalledInterrupts; ///< The number of called interrupt vectors.
+static bool gInInterrupt; ///< If an interrupt handler is running.
+static bool gSleeping; ///< If the CPU is sleeping.
+static FinishCallback gFinishCallback; ///< The callback at the end of the simulation.
+static Statistics gStatistics; ///< The collected statistics.
+static std::vector<KeyPress> gKeyPresses; ///< All scheduled key presses.
+static uint32_t gPulledLowPins; ///< A bit for each pin pulled low by an external component.
+static std::multimap<uint64_t, Event> gEvents; ///< All scheduled events, sorted by time.
+
+
+/// Get the period of timer 2 overflows in microseconds.
+///
+/// @return The period, or 0 if the timer or its interrupt is disabled.
+///
+static uint64_t getTimer2Period()
+{
+    const uint16_t prescaler = cTimer2Prescalers[TCCR2B & 0x07];
+    if (prescaler == 0 || (TIMSK2 & _BV(TOIE2)) == 0) {
+        return 0;
+    }
+    return (static_cast<uint64_t>(256) * prescaler * 1000000) / F_CPU;
+}
+
+
+/// Get the time from a start of timer 2 until its overflow.
+///
+/// The timer continues counting with the value it had when it stopped.
+///
+static uint64_t getTimer2StartPeriod()
+{
+    return (getTimer2Period() * (256 - gTimer2Counter)) / 256;
+}
+
+
+/// Get the selected sleep mode.
+///
+static uint8_t getSleepMode()
+{
+    return SMCR & (_BV(SM0)|_BV(SM1)|_BV(SM2));
+}
+
+
+/// Check if the timer 2 keeps running in the selected sleep mode.
+///
+static bool isTimer2RunningInSleepMode()
+{
+    const uint8_t sleepMode = getSleepMode();
+    return sleepMode == SLEEP_MODE_IDLE ||
+        sleepMode == SLEEP_MODE_ADC ||
+        sleepMode == SLEEP_MODE_PWR_SAVE ||
+        sleepMode == SLEEP_MODE_EXT_STANDBY;
+}
+
+
+/// Check if the timer 2 is currently running.
+///
+static bool isTimer2Running()
+{
+    return getTimer2Period() != 0 && (!gSleeping || isTimer2RunningInSleepMode());
+}
+
+
+/// Raise the pin change interrupt for a pin, if it is enabled.
+///
+static void onPinChanged(uint8_t pin)
+{
+    const uint8_t group = digitalPinToPCICRbit(pin);
+    if ((*digitalPinToPCMSK(pin) & _BV(digitalPinToPCMSKbit(pin))) != 0 && (PCICR & _BV(group)) != 0) {
+        PCIFR |= _BV(group);
+        raiseInterrupt(static_cast<Interrupt>(PinChangeInterrupt0 + group));
+    }
+}
+
+
+/// Raise the pin change interrupts for all keys pressed or released now.
+///
+static void onKeyChanged()
+{
+    for (const KeyPress &keyPress : gKeyPresses) {
+        if (keyPress.startMicros == gMicros || keyPress.endMicros == gMicros) {
+            onPinChanged(keyPress.pin);
+        }
+    }
+}
+
+
+/// Update the pending state of the external interrupt.
+///
+/// The low level interrupt is pending as long as the pin is low and
+/// the interrupt is enabled.
+///
+static void updateExternalInterrupt()
+{
+    const bool isLowLevel = (EICRA & (_BV(ISC01)|_BV(ISC00))) == 0;
+    if ((EIMSK & _BV(INT0)) != 0 && isLowLevel && isPinPulledLow(cExternalInterrupt0Pin)) {
+        raiseInterrupt(ExternalInterrupt0);
+    } else {
+        clearInterrupt(ExternalInterrupt0);
+    }
+}
+
+
+/// Call an interrupt vector.
+///
+static void callInterruptVector(uint8_t vector)
+{
+    switch (vector) {
+    case ExternalInterrupt0:
+        INT0_vect();
+        break;
+    case PinChangeInterrupt0:
+        PCIFR &= ~_BV(PCIF0); // Cleared by executing the vector.
+        PCINT0_vect();
+        break;
+    case PinChangeInterrupt1:
+        PCIFR &= ~_BV(PCIF1);
+        PCINT1_vect();
+        break;
+    case PinChangeInterrupt2:
+        PCIFR &= ~_BV(PCIF2);
+        PCINT2_vect();
+        break;
+    case Timer2OverflowInterrupt:
+        TIMER2_OVF_vect();
+        ++gStatistics.timer2Interrupts;
+        break;
+    case SpiTransferInterrupt:
+        SPSR &= ~_BV(SPIF); // Cleared by executing the vector.
+        SPI_STC_vect();
+        break;
+    case UsartTransmitInterrupt:
+        UCSR0A &= ~_BV(TXC0); // Cleared by executing the vector.
+        USART_TX_vect();
+        break;
+    case TwiInterrupt:
+        TWI_vect();
+        break;
+    default:
+        break;
+    }
+}
+
+
+/// Call all pending interrupts, if interrupts are enabled.
+///
+/// The interrupts are called in the order of their priority.
+///
+static void callPendingInterrupts()
+{
+    updateExternalInterrupt();
+    while (gInterruptsEnabled && !gInInterrupt && gPendingInterrupts != 0) {
+        uint8_t vector = 0;
+        while ((gPendingInterrupts & (static_cast<uint32_t>(1) << vector)) == 0) {
+            ++vector;
+        }
+        gPendingInterrupts &= ~(static_cast<uint32_t>(1) << vector);
+        gInterruptsEnabled = false;
+        gInInterrupt = true;
+        const auto start = std::chrono::steady_clock::now();
+        callInterruptVector(vector);
+        const auto end = std::chrono::steady_clock::now();
+        gInInterrupt = false;
+        gInterruptsEnabled = true;
+        gStatistics.interruptHostNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+        ++gCalledInterrupts;
+        updateExternalInterrupt();
+    }
+}
+
+
+void begin(uint64_t timeLimitMicros, FinishCallback finishCallback)
+{
+    gMicros = 0;
+    gTimeLimitMicros = timeLimitMicros;
+    gNextTimer2Overflow = 0;
+    gTimer2Counter = 0;
+    gInterruptsEnabled = false;
+    gPendingInterrupts = 0;
+    gCalledInterrupts = 0;
+    gInInterrupt = false;
+    gSleeping = false;
+    gFinishCallback = finishCallback;
+    gStatistics = Statistics();
+    gKeyPresses.clear();
+    gPulledLowPins = 0;
+    gEvents.clear();
+}
+
+
+uint64_t getMicros()
+{
+    return gMicros;
+}
+
+
+void advanceMicros(uint64_t micros)
+{
+    const uint64_t targetMicros = gMicros + micros;
+    callPendingInterrupts();
+    while (true) {
+        // Find the next timer overflow.
+        uint64_t nextMicros = targetMicros + 1;
+        if (isTimer2Running()) {
+            if (gNextTimer2Overflow == 0) {
+                gNextTimer2Overflow = gMicros + getTimer2StartPeriod();
+            }
+            nextMicros = gNextTimer2Overflow;
+        } else if (gNextTimer2Overflow != 0) {
+            gTimer2Counter = getTimer2Counter();
+            gNextTimer2Overflow = 0;
+        }
+        // Check if an event is first.
+        const bool isEventNext = !gEvents.empty() && gEvents.begin()->first < nextMicros;
+        if (isEventNext) {
+            nextMicros = gEvents.begin()->first;
+        }
+        if (nextMicros > targetMicros) {
+            break;
+        }
+        if (nextMicros > gMicros) {
+            gMicros = nextMicros;
+        }
+        if (isEventNext) {
+            const Event event = gEvents.begin()->second;
+            gEvents.erase(gEvents.begin());
+            if (event.requiresIoClock && gSleeping && getSleepMode() != SLEEP_MODE_IDLE) {
+                finish("An event requires the I/O clock, but it is stopped in the selected sleep mode.");
+            }
+            event.callback();
+        } else {
+            gNextTimer2Overflow += getTimer2Period();
+            raiseInterrupt(Timer2OverflowInterrupt);
+        }
+        callPendingInterrupts();
+    }
+    if (gMicros < targetMicros) {
+        gMicros = targetMicros;
+    }
+    if (gMicros >= gTimeLimitMicros && !gInInterrupt) {
+        finish("Time limit reached.");
+    }
+}
+
+
+void sleepUntilInterrupt()
+{
+    if ((SMCR & _BV(SE)) == 0) {
+        return; // The sleep instruction is ignored.
+    }
+    if (!gInterruptsEnabled) {
+        finish("Sleep with disabled interrupts, the CPU will never wake up.");
+    }
+    const uint32_t calledInterrupts = gCalledInterrupts;
+    callPendingInterrupts();
+    const uint64_t sleepStart = gMicros;
+    gSleeping = true;
+    while (gCalledInterrupts == calledInterrupts) {
+        uint64_t nextMicros = 0;
+        if (isTimer2Running()) {
+            if (gNextTimer2Overflow == 0) {
+                gNextTimer2Overflow = gMicros + getTimer2StartPeriod();
+            }
+            nextMicros = gNextTimer2Overflow;
+        }
+        if (!gEvents.empty() && (nextMicros == 0 || gEvents.begin()->first < nextMicros)) {
+            nextMicros = gEvents.begin()->first;
+        }
+        if (nextMicros == 0) {
+            finish("Sleep without any wake-up source.");
+        }
+        if (nextMicros > gTimeLimitMicros) {
+            nextMicros = gTimeLimitMicros; // End the simulation in time.
+        }
+        advanceMicros(nextMicros > gMicros ? (nextMicros - gMicros) : 0);
+    }
+    gSleeping = false;
+    gStatistics.sleepMicros += gMicros - sleepStart;
+    if (getSleepMode() == SLEEP_MODE_PWR_DOWN) {
+        gStatistics.powerDownMicros += gMicros - sleepStart;
+    }
+    ++gStatistics.wakeUps;
+}
+
+
+void setInterruptsEnabled(bool enabled)
+{
+    if (gInInterrupt) {
+        return; // The state is restored at the end of the interrupt.
+    }
+    gInterruptsEnabled = enabled;
+}
+
+
+uint8_t getTimer2Counter()
+{
+    const uint64_t period = getTimer2Period();
+    if (gNextTimer2Overflow == 0 || period == 0) {
+        return gTimer2Counter;
+    }
+    if (gNextTimer2Overflow <= gMicros) {
+        return 0;
+    }
+    const uint64_t remainingCounts = ((gNextTimer2Overflow - gMicros) * 256 + period - 1) / period;
+    return static_cast<uint8_t>(256 - remainingCounts);
+}
+
+
+void setTimer2Counter(uint8_t value)
+{
+    gTimer2Counter = value;
+    if (gNextTimer2Overflow != 0) {
+        gNextTimer2Overflow = gMicros + getTimer2StartPeriod();
+    }
+}
+
+
+bool areInterruptsEnabled()
+{
+    return gInterruptsEnabled;
+}
+
+
+void raiseInterrupt(Interrupt interrupt)
+{
+    gPendingInterrupts |= (static_cast<uint32_t>(1) << interrupt);
+}
+
+
+void clearInterrupt(Interrupt interrupt)
+{
+    gPendingInterrupts &= ~(static_cast<uint32_t>(1) << interrupt);
+}
+
+
+void scheduleEvent(uint64_t micros, EventCallback callback, bool requiresIoClock)
+{
+    Event event;
+    event.callback = callback;
+    event.requiresIoClock = requiresIoClock;
+    gEvents.insert(std::make_pair(micros, event));
+}
+
+
+void cancelEvents(EventCallback callback)
+{
+    for (auto it = gEvents.begin(); it != gEvents.end();) {
+        if (it->second.callback == callback) {
+            it = gEvents.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+void scheduleKeyPress(uint8_t pin, uint64_t startMicros, uint64_t durationMicros)
+{
+    KeyPress keyPress;
+    keyPress.pin = pin;
+    keyPress.startMicros = startMicros;
+    keyPress.endMicros = startMicros + durationMicros;
+    gKeyPresses.push_back(keyPress);
+    scheduleEvent(keyPress.startMicros, &onKeyChanged, false);
+    scheduleEvent(keyPress.endMicros, &onKeyChanged, false);
+}
+
+
+void setPinPulledLow(uint8_t pin, bool pulledLow)
+{
+    const uint32_t mask = (static_cast<uint32_t>(1) << pin);
+    if (((gPulledLowPins & mask) != 0) == pulledLow) {
+        return;
+    }
+    if (pulledLow) {
+        gPulledLowPins |= mask;
+    } else {
+        gPulledLowPins &= ~mask;
+    }
+    onPinChanged(pin);
+    updateExternalInterrupt();
+}
+
+
+bool isPinPulledLow(uint8_t pin)
+{
+    if ((gPulledLowPins & (static_cast<uint32_t>(1) << pin)) != 0) {
+        return true;
+    }
+    for (const KeyPress &keyPress : gKeyPresses) {
+        if (keyPress.pin == pin && gMicros >= keyPress.startMicros && gMicros < keyPress.endMicros) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+Statistics& getStatistics()
+{
+    return gStatistics;
+}
+
+
+void finish(const char *reason)
+{
+    fflush(stdout);
+    fprintf(stderr, "\n%s\n", reason);
+    if (gFinishCallback != nullptr) {
+        gFinishCallback();
+    }
+    exit(0);
+}
+
+
+}
+}
+
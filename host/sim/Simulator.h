@@ -0,0 +1,192 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include <stdint.h>
+
+
+namespace lr {
+
+
+/// The simulator for host builds of the firmware.
+///
+/// The simulator keeps a virtual time, which only advances if the
+/// firmware waits, sleeps or transfers data. This allows the firmware
+/// to run much faster than real-time. Every time the virtual time
+/// passes a timer 2 overflow or another event of the simulated hardware,
+/// the interrupt vector is called exactly as on the real hardware.
+///
+namespace Simulator {
+
+
+/// Statistics collected while the firmware is running.
+///
+struct Statistics {
+    uint64_t sleepMicros; ///< The virtual time the CPU was sleeping.
+    uint64_t powerDownMicros; ///< The virtual time the CPU was sleeping in the power-down mode.
+    uint32_t wakeUps; ///< The number of times the CPU woke up from sleep.
+    uint32_t timer2Interrupts; ///< The number of timer 2 overflow interrupts.
+    uint64_t interruptHostNanos; ///< The host time spent in interrupt handlers.
+    uint32_t i2cTransactions; ///< The number of I2C transactions.
+    uint32_t i2cBytes; ///< The number of bytes transferred over the I2C bus.
+    uint64_t i2cBusMicros; ///< The virtual time the I2C bus was busy.
+    uint32_t spiBytes; ///< The number of bytes sent using the SPI or the USART in SPI mode.
+    uint64_t spiBusMicros; ///< The virtual time the SPI bus was busy.
+    uint32_t sensorReads; ///< The number of reads started on the sensor.
+};
+
+/// The interrupt vectors of the simulated hardware.
+///
+/// The values are the vector numbers of the ATmega328P, a lower
+/// number means a higher priority.
+///
+enum Interrupt : uint8_t {
+    ExternalInterrupt0 = 1, ///< INT0_vect
+    PinChangeInterrupt0 = 3, ///< PCINT0_vect
+    PinChangeInterrupt1 = 4, ///< PCINT1_vect
+    PinChangeInterrupt2 = 5, ///< PCINT2_vect
+    Timer2OverflowInterrupt = 9, ///< TIMER2_OVF_vect
+    SpiTransferInterrupt = 17, ///< SPI_STC_vect
+    UsartTransmitInterrupt = 20, ///< USART_TX_vect
+    TwiInterrupt = 24, ///< TWI_vect
+};
+
+/// The type for the function called when the simulation ends.
+///
+typedef void (*FinishCallback)();
+
+/// The type for the function called for a scheduled event.
+///
+typedef void (*EventCallback)();
+
+
+/// Initialize the simulator.
+///
+/// @param timeLimitMicros The virtual time after which the simulation ends.
+/// @param finishCallback A function which is called when the simulation ends.
+///
+void begin(uint64_t timeLimitMicros, FinishCallback finishCallback);
+
+/// Get the current virtual time in microseconds.
+///
+uint64_t getMicros();
+
+/// Advance the virtual time.
+///
+/// All interrupts which occur in this time are called. If interrupts are
+/// disabled, they are called as soon as interrupts get enabled again.
+/// If the time limit is reached, the simulation ends.
+///
+void advanceMicros(uint64_t micros);
+
+/// Sleep until the next interrupt.
+///
+/// This is the implementation of the sleep instruction. It respects the
+/// sleep enable bit and the selected sleep mode.
+///
+void sleepUntilInterrupt();
+
+/// Enable or disable interrupts.
+///
+/// Pending interrupts are not called immediately after enabling the
+/// interrupts, but at the next sleep instruction or if the time advances.
+/// Like on the real hardware, this allows to enable the interrupts and
+/// sleep without missing an interrupt.
+///
+void setInterruptsEnabled(bool enabled);
+
+/// Mark an interrupt as pending.
+///
+/// The interrupt vector is called as soon as interrupts are enabled.
+///
+void raiseInterrupt(Interrupt interrupt);
+
+/// Remove the pending flag of an interrupt.
+///
+void clearInterrupt(Interrupt interrupt);
+
+/// Schedule an event of the simulated hardware.
+///
+/// @param micros The virtual time of the event.
+/// @param callback The function to call at this time.
+/// @param requiresIoClock If the event requires the I/O clock, which is
+///    stopped in all sleep modes except the idle mode.
+///
+void scheduleEvent(uint64_t micros, EventCallback callback, bool requiresIoClock);
+
+/// Remove all scheduled events with the given callback.
+///
+void cancelEvents(EventCallback callback);
+
+/// Check if interrupts are enabled.
+///
+bool areInterruptsEnabled();
+
+/// Get the current value of the timer 2 counter.
+///
+uint8_t getTimer2Counter();
+
+/// Write the timer 2 counter.
+///
+/// If the timer is running, this moves its next overflow.
+///
+void setTimer2Counter(uint8_t value);
+
+/// Schedule a key press.
+///
+/// The given pin is pulled low for the given duration. The changes of
+/// the pin raise its pin change interrupt, if it is enabled.
+///
+/// @param pin The pin of the key.
+/// @param startMicros The virtual time when the key is pressed.
+/// @param durationMicros How long the key is held down.
+///
+void scheduleKeyPress(uint8_t pin, uint64_t startMicros, uint64_t durationMicros);
+
+/// Pull a pin low or release it, as an output of a simulated external component.
+///
+/// This raises the pin change interrupt of the pin, if it is enabled.
+/// A low level on pin 2 raises the external interrupt INT0, while it is
+/// enabled for the low level.
+///
+/// @param pin The pin.
+/// @param pulledLow true to pull the pin low, false to release it.
+///
+void setPinPulledLow(uint8_t pin, bool pulledLow);
+
+/// Check if a pin is pulled low by a simulated external component.
+///
+bool isPinPulledLow(uint8_t pin);
+
+/// Access the statistics.
+///
+Statistics& getStatistics();
+
+/// End the simulation.
+///
+/// This calls the finish callback and terminates the process.
+///
+void finish(const char *reason);
+
+
+}
+}
+
@@ -0,0 +1,58 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "SpiBus.h"
+
+
+#include <vector>
+
+
+namespace lr {
+namespace Simulator {
+
+
+SpiDevice::~SpiDevice()
+{
+}
+
+
+namespace SpiBus {
+
+
+static std::vector<SpiDevice*> gDevices; ///< All attached devices.
+
+
+void attach(SpiDevice *device)
+{
+    gDevices.push_back(device);
+}
+
+
+void send(uint8_t byte)
+{
+    for (SpiDevice *device : gDevices) {
+        device->receive(byte);
+    }
+}
+
+
+}
+}
+}
+
@@ -0,0 +1,68 @@
+#pragma once
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+#include <stdint.h>
+
+
+namespace lr {
+namespace Simulator {
+
+
+/// The base class of all simulated devices on the SPI bus.
+///
+/// The device receives all bytes sent by the SPI hardware or by the
+/// USART in SPI mode. The chip select signal is not simulated.
+///
+class SpiDevice
+{
+public:
+    /// dtor
+    ///
+    virtual ~SpiDevice();
+
+public:
+    /// Receive a byte.
+    ///
+    /// This is called at the end of the transfer of the byte.
+    ///
+    virtual void receive(uint8_t byte) = 0;
+};
+
+
+/// The simulated SPI bus.
+///
+namespace SpiBus {
+
+
+/// Attach a device to the bus.
+///
+void attach(SpiDevice *device);
+
+/// Send a byte to all attached devices.
+///
+void send(uint8_t byte);
+
+
+}
+}
+}
+
@@ -0,0 +1,349 @@
+//
+// Lucky Resistor's Deluxe Data Logger
+// ---------------------------------------------------------------------------
+// (c)2015 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+
+// The entry point of the host simulator.
+//
+// Usage: DataLoggerDeluxe [-t seconds] [-f image] [-m storage] [-c chips] [-d date] [-k keys] [-i interface] [-p image] [-s]
+//
+//   -t seconds  The virtual time to simulate (default: 3600).
+//   -f image    Load the FRAM contents from this file and save them at the end.
+//               With the file storage, the file is mapped into memory.
+//   -m storage  The storage backend, one of fram (default), eeprom or file.
+//               The file storage works at memory speed, without the I2C bus.
+//   -c chips    The number of FRAM chips on the bus, 1-8 (default: 1).
+//   -d date     The initial time of the RTC as "yyyy-MM-dd hh:mm:ss".
+//   -k keys     Key presses as list of "ms:key", key is one of
+//               up, down, left, right or enter. Example: "5000:enter"
+//   -i interface The interface of the display, one of software (default), spi
+//               or usart. The hardware interfaces use the rewiring described in
+//               config.h, with the enter key on pin 7 for the USART.
+//   -p image    Save the pixels of the display as PBM image at the end. Only the
+//               hardware interfaces are decoded by the simulated display.
+//   -s          Print the text on the display at the end of the simulation.
+
+
+#include "DS3231Device.h"
+#include "FramDevice.h"
+#include "I2CBus.h"
+#include "SharpDisplayDevice.h"
+#include "Simulator.h"
+
+#include <string>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Application.h"
+#include "config.h"
+#include "DateTime.h"
+#include "EepromStorage.h"
+#include "FileStorage.h"
+#include "KeyPad.h"
+#include "SharpDisplay.h"
+#include "Storage.h"
+
+
+// The sketch functions.
+void setup();
+void loop();
+
+
+using namespace lr;
+
+
+// The pins of the keys, matching the key pad wiring.
+static const uint8_t cKeyUpPin = 6;
+static const uint8_t cKeyDownPin = 8;
+static const uint8_t cKeyLeftPin = 5;
+static const uint8_t cKeyRightPin = 12;
+static const uint8_t cKeyEnterPin = KEY_ENTER_PIN;
+
+// The pin of the enter key, if the display uses the USART interface.
+static const uint8_t cUsartKeyEnterPin = 7;
+
+// The duration of a simulated key press.
+static const uint64_t cKeyPressMicros = 100000;
+
+static std::vector<Simulator::FramDevice*> gFrams; ///< The FRAM chips.
+static Simulator::FramDeviceIdResponder gFramDeviceId; ///< The device ID responder of the FRAM.
+static Simulator::DS3231Device *gRtc; ///< The real time clock.
+static const char *gFramImagePath; ///< The path for the FRAM image or nullptr.
+static bool gUseFram = true; ///< Flag if the storage uses the simulated FRAM.
+static bool gPrintScreen; ///< Flag if the display is printed at the end.
+static uint8_t gKeyEnterPin = cKeyEnterPin; ///< The pin of the enter key.
+static Simulator::SharpDisplayDevice gDisplay; ///< The display on the SPI bus.
+static bool gUseDisplay; ///< Flag if the display uses a hardware interface.
+static const char *gDisplayImagePath; ///< The path for the display image or nullptr.
+
+
+/// Print the text on the display.
+///
+/// Special characters outside of the ASCII range are printed as '#'.
+///
+static void printScreen()
+{
+    fprintf(stderr, "+------------+\n");
+    for (uint8_t row = 0; row < SharpDisplay::getScreenHeight(); ++row) {
+        fprintf(stderr, "|");
+        for (uint8_t column = 0; column < SharpDisplay::getScreenWidth(); ++column) {
+            const uint8_t c = static_cast<uint8_t>(SharpDisplay::getCharacter(row, column));
+            fputc((c >= 0x20 && c < 0x7f) ? c : '#', stderr);
+        }
+        fprintf(stderr, "|\n");
+    }
+    fprintf(stderr, "+------------+\n");
+}
+
+
+/// Load the contents of all FRAM chips from the image.
+///
+/// The image contains the memory of all chips in the order of their
+/// address. Chips which are missing in the image start empty.
+///
+static void loadFramImage()
+{
+    FILE *file = fopen(gFramImagePath, "rb");
+    if (file == nullptr) {
+        return;
+    }
+    for (Simulator::FramDevice *fram : gFrams) {
+        if (!fram->loadFromFile(file)) {
+            break;
+        }
+    }
+    fclose(file);
+}
+
+
+/// Save the contents of all FRAM chips to the image.
+///
+static bool saveFramImage()
+{
+    FILE *file = fopen(gFramImagePath, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool success = true;
+    for (const Simulator::FramDevice *fram : gFrams) {
+        success &= fram->saveToFile(file);
+    }
+    return (fclose(file) == 0) && success;
+}
+
+
+/// Save the pixels of the display to the image.
+///
+static bool saveDisplayImage()
+{
+    FILE *file = fopen(gDisplayImagePath, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool success = gDisplay.saveToFile(file);
+    return (fclose(file) == 0) && success;
+}
+
+
+/// Print the collected statistics and save the FRAM image.
+///
+static void finishSimulation()
+{
+    if (gPrintScreen) {
+        printScreen();
+    }
+    const Simulator::Statistics &statistics = Simulator::getStatistics();
+    const double totalSeconds = static_cast<double>(Simulator::getMicros()) / 1000000.0;
+    const double sleepSeconds = static_cast<double>(statistics.sleepMicros) / 1000000.0;
+    const double powerDownSeconds = static_cast<double>(statistics.powerDownMicros) / 1000000.0;
+    fprintf(stderr, "Virtual time:      %.3f s\n", totalSeconds);
+    fprintf(stderr, "Sleep time:        %.3f s (%.1f%%)\n", sleepSeconds, (totalSeconds > 0.0 ? sleepSeconds * 100.0 / totalSeconds : 0.0));
+    fprintf(stderr, "Power-down time:   %.3f s (%.1f%%)\n", powerDownSeconds, (totalSeconds > 0.0 ? powerDownSeconds * 100.0 / totalSeconds : 0.0));
+    fprintf(stderr, "Wake-ups:          %u\n", statistics.wakeUps);
+    fprintf(stderr, "Timer2 interrupts: %u (host time %.3f ms)\n", statistics.timer2Interrupts, static_cast<double>(statistics.interruptHostNanos) / 1000000.0);
+    fprintf(stderr, "I2C transactions:  %u (%u bytes, bus time %.3f ms)\n", statistics.i2cTransactions, statistics.i2cBytes, static_cast<double>(statistics.i2cBusMicros) / 1000.0);
+    fprintf(stderr, "SPI bytes:         %u (bus time %.3f ms)\n", statistics.spiBytes, static_cast<double>(statistics.spiBusMicros) / 1000.0);
+    if (gUseDisplay) {
+        fprintf(stderr, "Display frames:    %u (%u protocol errors)\n", gDisplay.getFrameCount(), gDisplay.getErrorCount());
+    }
+    fprintf(stderr, "Sensor reads:      %u\n", statistics.sensorReads);
+    if (gUseFram && gFramImagePath != nullptr && !saveFramImage()) {
+        fprintf(stderr, "Could not save the FRAM image to %s\n", gFramImagePath);
+    }
+    if (gDisplayImagePath != nullptr && !saveDisplayImage()) {
+        fprintf(stderr, "Could not save the display image to %s\n", gDisplayImagePath);
+    }
+}
+
+
+/// Parse the key script and schedule all key presses.
+///
+static bool scheduleKeys(const char *script)
+{
+    std::string remaining(script);
+    while (!remaining.empty()) {
+        const size_t end = remaining.find(',');
+        const std::string entry = remaining.substr(0, end);
+        remaining = (end == std::string::npos) ? std::string() : remaining.substr(end + 1);
+        const size_t separator = entry.find(':');
+        if (separator == std::string::npos) {
+            return false;
+        }
+        const uint64_t startMicros = strtoull(entry.substr(0, separator).c_str(), nullptr, 10) * 1000;
+        const std::string key = entry.substr(separator + 1);
+        uint8_t pin;
+        if (key == "up") {
+            pin = cKeyUpPin;
+        } else if (key == "down") {
+            pin = cKeyDownPin;
+        } else if (key == "left") {
+            pin = cKeyLeftPin;
+        } else if (key == "right") {
+            pin = cKeyRightPin;
+        } else if (key == "enter") {
+            pin = gKeyEnterPin;
+        } else {
+            return false;
+        }
+        Simulator::scheduleKeyPress(pin, startMicros, cKeyPressMicros);
+    }
+    return true;
+}
+
+
+/// Parse the initial date/time for the RTC.
+///
+static bool parseDateTime(const char *text, uint32_t &secondsSince2000)
+{
+    unsigned int year, month, day, hour, minute, second;
+    if (sscanf(text, "%u-%u-%u %u:%u:%u", &year, &month, &day, &hour, &minute, &second) != 6) {
+        return false;
+    }
+    secondsSince2000 = DateTime(year, month, day, hour, minute, second).toSecondsSince2000();
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint64_t timeLimitMicros = 3600ull * 1000000;
+    uint32_t startTime = DateTime(2015, 10, 1, 12, 0, 0).toSecondsSince2000();
+    const char *keyScript = nullptr;
+    const char *storage = "fram";
+    const char *displayInterface = "software";
+    int framCount = 1;
+    int option;
+    while ((option = getopt(argc, argv, "t:f:m:c:d:k:i:p:s")) != -1) {
+        switch (option) {
+            case 't':
+                timeLimitMicros = strtoull(optarg, nullptr, 10) * 1000000;
+                break;
+            case 'f':
+                gFramImagePath = optarg;
+                break;
+            case 'm':
+                storage = optarg;
+                break;
+            case 'c':
+                framCount = atoi(optarg);
+                if (framCount < 1 || framCount > 8) {
+                    fprintf(stderr, "Invalid number of FRAM chips: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'd':
+                if (!parseDateTime(optarg, startTime)) {
+                    fprintf(stderr, "Invalid date/time: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'k':
+                keyScript = optarg;
+                break;
+            case 'i':
+                displayInterface = optarg;
+                break;
+            case 'p':
+                gDisplayImagePath = optarg;
+                break;
+            case 's':
+                gPrintScreen = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-t seconds] [-f image] [-m storage] [-c chips] [-d date] [-k keys] [-i interface] [-p image] [-s]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (strcmp(storage, "eeprom") == 0) {
+        Storage::setBackend(EepromStorage::getBackend());
+        gUseFram = false;
+    } else if (strcmp(storage, "file") == 0) {
+        Simulator::FileStorage::setPath(gFramImagePath);
+        Storage::setBackend(Simulator::FileStorage::getBackend());
+        gUseFram = false;
+    } else if (strcmp(storage, "fram") != 0) {
+        fprintf(stderr, "Unknown storage: %s\n", storage);
+        return 1;
+    }
+
+    if (strcmp(displayInterface, "spi") == 0) {
+        Application::setDisplayInterface(SharpDisplay::HardwareSpiInterface);
+        gUseDisplay = true;
+    } else if (strcmp(displayInterface, "usart") == 0) {
+        // The clock of the USART is the enter key of the default wiring.
+        Application::setDisplayInterface(SharpDisplay::UsartSpiInterface);
+        KeyPad::setKeyPin(KeyPad::Enter, cUsartKeyEnterPin);
+        gKeyEnterPin = cUsartKeyEnterPin;
+        gUseDisplay = true;
+    } else if (strcmp(displayInterface, "software") != 0) {
+        fprintf(stderr, "Unknown display interface: %s\n", displayInterface);
+        return 1;
+    }
+
+    Simulator::begin(timeLimitMicros, &finishSimulation);
+    if (keyScript != nullptr && !scheduleKeys(keyScript)) {
+        fprintf(stderr, "Invalid key script: %s\n", keyScript);
+        return 1;
+    }
+    for (int i = 0; i < framCount; ++i) {
+        gFrams.push_back(new Simulator::FramDevice(0x50 + i));
+    }
+    if (gUseFram && gFramImagePath != nullptr) {
+        loadFramImage(); // A missing image starts with empty chips.
+    }
+    gRtc = new Simulator::DS3231Device(startTime);
+    for (Simulator::FramDevice *fram : gFrams) {
+        Simulator::I2CBus::attach(fram);
+    }
+    Simulator::I2CBus::attach(&gFramDeviceId);
+    Simulator::I2CBus::attach(gRtc);
+    Simulator::SpiBus::attach(&gDisplay);
+
+    // Run the sketch until the time limit is reached.
+    setup();
+    while (true) {
+        loop();
+    }
+    return 0;
+}
+